@@ -79,6 +79,7 @@ def amalgamate_source(source_top_dir=None,
     header.add_file(os.path.join(INCLUDE_PATH, "value.h"))
     header.add_file(os.path.join(INCLUDE_PATH, "reader.h"))
     header.add_file(os.path.join(INCLUDE_PATH, "writer.h"))
+    header.add_file(os.path.join(INCLUDE_PATH, "query.h"))
     header.add_file(os.path.join(INCLUDE_PATH, "assertions.h"))
     header.add_text("#endif //ifndef JSON_AMALGAMATED_H_INCLUDED")
 
@@ -128,6 +129,7 @@ def amalgamate_source(source_top_dir=None,
     source.add_file(os.path.join(SRC_PATH, "json_valueiterator.inl"))
     source.add_file(os.path.join(SRC_PATH, "json_value.cpp"))
     source.add_file(os.path.join(SRC_PATH, "json_writer.cpp"))
+    source.add_file(os.path.join(SRC_PATH, "json_query.cpp"))
 
     print("Writing amalgamated source to %r" % target_source_path)
     source.write_to(target_source_path)
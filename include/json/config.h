@@ -17,6 +17,10 @@
 #define JSON_USE_NULLREF 1
 #endif
 
+#ifndef JSON_USE_ALLOCATION_HOOKS
+#define JSON_USE_ALLOCATION_HOOKS 0
+#endif
+
 #if defined(JSON_DLL_BUILD)
 #if defined(_MSC_VER) || defined(__MINGW32__)
 #define JSON_API __declspec(dllexport)
@@ -28,6 +28,7 @@ class Value;
 class ValueIteratorBase;
 class ValueIterator;
 class ValueConstIterator;
+template <typename IteratorT> class ItemRange;
 
 } // namespace Json
 
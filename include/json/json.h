@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include "json_features.h"
+#include "query.h"
 #include "reader.h"
 #include "value.h"
 #include "writer.h"
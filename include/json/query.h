@@ -0,0 +1,105 @@
+#ifndef JSON_QUERY_H_INCLUDED
+#define JSON_QUERY_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "value.h"
+#endif
+#include <memory>
+#include <vector>
+
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING) && defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif
+
+#pragma pack(push)
+#pragma pack()
+
+namespace Json {
+
+/*!
+\class Query
+\brief A JSONPath query (RFC 9535), compiled once and evaluated against any number of documents.
+
+Supports the root and current node identifiers, name and wildcard shorthands, bracketed selections with names, indices, slices, wildcards and filters, and descendant segments.
+Filters combine comparisons, existence tests, !, && and || over literals and queries, and may call the length(), count() and value() functions; match() and search() are not available, as the library has no regular expression engine.
+
+select() walks the tree with an explicit stack and returns pointers into it, so no value is copied and deep documents do not exhaust the call stack.
+selectText() applies the query directly to JSON text without building a tree, for the queries that isStreamable() accepts.
+
+\code
+Json::Query query;
+Json::String error;
+if (Json::Query::compile("$.store.book[?@.price < 10].title", &query, &error))
+  for (Json::Value const* title : query.select(root))
+    std::cout << title->asString() << "\n";
+\endcode
+
+A compiled query is immutable; copies share its plan, and it may be evaluated from several threads at once.
+*/
+class JSON_API Query {
+public:
+  /// An empty query, which selects nothing until a query is compiled into it.
+  Query();
+
+  /*!
+  \brief Compiles a JSONPath expression.
+  
+  \param expression The query text, starting with '$'.
+  \param query Receives the compiled query; left unchanged on failure.
+  \param error If not null, receives a description of the first syntax error and its offset.
+  
+  \return true if the expression was compiled.
+  */
+  static bool compile(StringView expression, Query* query, String* error);
+
+  /*!
+  \brief Appends the nodes selected in root to out.
+  
+  The nodes come in the order RFC 9535 defines, with members of an object visited in key order; a node may appear more than once if the query selects it several times.
+  
+  \param root The document, which is the node that '$' refers to.
+  \param out Receives pointers to the selected values, which stay valid as long as the document is not modified.
+  */
+  void select(const Value& root, std::vector<Value const*>& out) const;
+  /// Returns the nodes selected in root.
+  std::vector<Value const*> select(const Value& root) const;
+
+  /*!
+  \brief Tells whether selectText() can evaluate this query.
+  
+  Streaming needs to decide whether a value is selected from its position alone, so the query must not contain filters, negative indices or slices that count from the end or go backwards, and must have fewer than 64 segments.
+  */
+  bool isStreamable() const;
+
+  /*!
+  \brief Finds the values the query selects in a JSON text, without parsing it into a tree.
+  
+  The text is scanned once and its syntax is checked throughout; containers under which nothing can match are scanned without tracking the query or decoding member names.
+  Each selected value is reported once, as the range of its text, in the order the values begin.
+  
+  \param begin Start of the JSON text.
+  \param end End of the JSON text.
+  \param out Receives views of the text of the selected values, pointing into [begin, end).
+  
+  \return false if the query is not streamable or the text is not well-formed JSON; out may then hold partial results.
+  */
+  bool selectText(char const* begin, char const* end,
+                  std::vector<StringView>& out) const;
+
+private:
+  class Impl;
+  explicit Query(std::shared_ptr<Impl const> impl);
+
+  std::shared_ptr<Impl const> impl_;
+};
+
+} // namespace Json
+
+#pragma pack(pop)
+
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(pop)
+#endif
+
+#endif
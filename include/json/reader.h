@@ -10,6 +10,7 @@
 #include <istream>
 #include <stack>
 #include <string>
+#include <vector>
 
 #if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
 #pragma warning(push)
@@ -21,6 +22,61 @@
 
 namespace Json {
 
+/*!
+\class LineIndex
+\brief Maps byte offsets in a document to 1-based line and column numbers.
+
+The offsets of the line starts are collected on the first lookup and reused by every later one, so reporting many errors, or locating many values, costs one scan of the document instead of one scan per lookup.
+"\r\n", a lone '\r' and '\n' each end a line; columns count bytes.
+Use it to turn Value::getOffsetStart() and Value::getOffsetLimit() into positions: the offsets are relative to the first byte the reader parsed, which is after a skipped UTF-8 BOM.
+The document must outlive the index. The first lookup fills the index, so sharing one instance between threads requires external synchronization.
+*/
+class JSON_API LineIndex {
+public:
+  LineIndex();
+  /*!
+  \brief Creates an index over the characters in [begin, end).
+  
+  Nothing is scanned until the first lookup.
+  
+  \param begin The first character of the document.
+  \param end One past the last character of the document.
+  */
+  LineIndex(char const* begin, char const* end);
+
+  /*!
+  \brief Points the index at another document, discarding the line starts collected so far.
+  
+  \param begin The first character of the document.
+  \param end One past the last character of the document.
+  */
+  void reset(char const* begin, char const* end);
+
+  /*!
+  \brief Converts a byte offset into a 1-based line and column.
+  
+  Offsets outside the document are clamped to it.
+  
+  \param offset The number of bytes from the start of the document.
+  \param line Receives the line number.
+  \param column Receives the column number.
+  */
+  void lineAndColumn(ptrdiff_t offset, int& line, int& column) const;
+
+  /*!
+  \brief Returns the number of lines in the document; an empty document has one.
+  */
+  size_t lineCount() const;
+
+private:
+  void build() const;
+
+  char const* begin_;
+  char const* end_;
+  mutable std::vector<size_t> lineStarts_;
+  mutable bool built_;
+};
+
 /*!
 \class Reader
 \brief Parses and interprets JSON-formatted data.
@@ -576,6 +632,43 @@ private:
   bool collectComments_{};
 };
 /*!
+\struct ParseStats
+\brief Counters and phase timings collected by a CharReader.
+
+Pass an instance to CharReaderBuilder::newCharReader(ParseStats*) to find out what a document cost to parse without attaching a profiler.
+Every call to CharReader::parse() resets the counters before filling them in, also when parsing fails; in that case they describe the part of the input read before the error.
+Token counts include member names and values alike, so strings counts the member names too.
+The phase timings are wall-clock nanoseconds; stringNanoseconds and numberNanoseconds are included in parseNanoseconds.
+*/
+struct JSON_API ParseStats {
+  /// Bytes up to the end of the root value; anything after it is not counted.
+  size_t bytesConsumed = 0;
+  size_t objects = 0;
+  size_t arrays = 0;
+  /// String tokens, member names included.
+  size_t strings = 0;
+  size_t memberNames = 0;
+  size_t numbers = 0;
+  /// true, false and null tokens.
+  size_t literals = 0;
+  /// NaN and Infinity tokens accepted by allowSpecialFloats.
+  size_t specialFloats = 0;
+  size_t comments = 0;
+  /// Escape sequences decoded in strings and member names.
+  size_t escapes = 0;
+  /// Numbers converted by the integer path.
+  size_t integers = 0;
+  /// Numbers converted by the floating point path.
+  size_t doubles = 0;
+  /// Deepest nesting of arrays and objects; a scalar document has depth 1.
+  size_t maxDepth = 0;
+  /// Values created, the root included.
+  size_t nodes = 0;
+  Int64 parseNanoseconds = 0;
+  Int64 stringNanoseconds = 0;
+  Int64 numberNanoseconds = 0;
+};
+/*!
 \class CharReader
 \brief Reads and parses JSON documents from character streams.
 
@@ -628,6 +721,17 @@ public:
   */
   std::vector<StructuredError> getStructuredErrors() const;
 
+  /*!
+  \brief Forgets the last parsed document.
+  
+  Clears the errors and every reference into the previous input, but keeps the memory of the internal buffers, so that a reader reused for many documents stops allocating once it has seen the largest of them.
+  parse() starts from the same state by itself; call reset() when the reader is kept idle, or after parse() threw, so that it no longer points into a document that is about to be freed.
+  Reuse one reader per thread instead of calling CharReaderBuilder::newCharReader() per document: the builder interprets its settings on every call, while a reader keeps them compiled.
+  To return the buffers' memory, destroy the reader.
+  Readers that were not made by CharReaderBuilder are left unchanged.
+  */
+  void reset();
+
   /*!
   \class Factory
   \brief Serves as an abstract factory for creating CharReader objects.
@@ -709,6 +813,8 @@ private:
 Provides a flexible way to configure JSON parsing options.
 Allows fine-tuning of settings such as comment handling, trailing comma acceptance, and numeric key allowance.
 Offers methods for setting default configurations, enforcing strict parsing rules, or adhering to ECMA-404 standards, giving developers precise control over the JSON parsing process.
+With "recycleValues" set to true, parse() reuses the tree already held by its root argument instead of releasing it: values whose type is unchanged keep their map nodes, member names and string buffers, and only the parts that differ are allocated or freed.
+Repeatedly parsing messages of the same shape into the same Value then allocates next to nothing, with the same result as parsing into a fresh Value.
 */
 class JSON_API CharReaderBuilder : public CharReader::Factory {
 public:
@@ -732,6 +838,16 @@ public:
   \return A pointer to a newly created CharReader object. The caller is responsible for managing the memory of this object.
   */
   CharReader* newCharReader() const override;
+  /*!
+  \brief Creates a new CharReader that collects parse counters.
+
+  Every call to parse() on the returned reader resets *stats and fills it in, also when parsing fails.
+
+  \param stats The object to fill in, or nullptr to collect nothing. It must outlive the returned reader.
+
+  \return A pointer to a newly created CharReader object. The caller is responsible for managing the memory of this object.
+  */
+  CharReader* newCharReader(ParseStats* stats) const;
 
   /*!
   \brief Validates the current settings of the CharReaderBuilder.
@@ -29,10 +29,21 @@
 #endif
 
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <exception>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
+// MSVC keeps __cplusplus at 199711L unless /Zc:__cplusplus is given, and
+// reports the language version in _MSVC_LANG instead.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#endif
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
@@ -181,6 +192,190 @@ private:
   const char* c_str_;
 };
 
+/*!
+\class StringView
+\brief Refers to a range of characters owned by someone else, such as the name of an object member.
+
+Plays the part of std::string_view, which is not available before C++17, and converts to it when it is.
+Copying a view never copies the characters, so the owner must outlive it; the range is not null-terminated in general.
+*/
+class StringView {
+public:
+  StringView() = default;
+  StringView(char const* data, size_t length) : data_(data), length_(length) {}
+  StringView(char const* czstring)
+      : data_(czstring), length_(czstring ? strlen(czstring) : 0) {}
+  StringView(String const& string)
+      : data_(string.data()), length_(string.size()) {}
+
+  char const* data() const { return data_; }
+  size_t size() const { return length_; }
+  size_t length() const { return length_; }
+  bool empty() const { return length_ == 0; }
+  char const* begin() const { return data_; }
+  char const* end() const { return data_ + length_; }
+  char operator[](size_t index) const { return data_[index]; }
+
+  /// Copies the characters into a new String.
+  String toString() const { return empty() ? String() : String(data_, length_); }
+
+#if defined(__cpp_lib_string_view)
+  operator std::string_view() const { return {data_, length_}; }
+#endif
+
+  friend bool operator==(StringView a, StringView b) {
+    return a.length_ == b.length_ &&
+           (a.length_ == 0 || memcmp(a.data_, b.data_, a.length_) == 0);
+  }
+  friend bool operator!=(StringView a, StringView b) { return !(a == b); }
+
+private:
+  char const* data_{nullptr};
+  size_t length_{0};
+};
+
+/*!
+\brief Identifies the code that made an allocation reported to an AllocationObserver.
+*/
+enum AllocationSite {
+  /// Copy of a member name or string made by duplicateStringValue().
+  duplicatedString = 0,
+  /// Length-prefixed string value made by duplicateAndPrefixStringValue().
+  prefixedString,
+  /// The map holding the elements or members of an array or object.
+  objectValuesMap,
+  /// One element or member inserted in such a map, including the tree node.
+  objectValuesNode,
+  /// The storage of the comments attached to a value.
+  commentStorage,
+  /// An error recorded by a reader.
+  readerError,
+  /// A comment collected by a reader.
+  readerComment,
+
+  numberOfAllocationSites
+};
+
+/*!
+\brief Returns the name of an allocation site, such as "duplicateStringValue".
+
+\param site The allocation site to name.
+
+\return A static string naming the function or structure that allocates.
+*/
+JSON_API char const* allocationSiteName(AllocationSite site);
+
+/*!
+\class AllocationObserver
+\brief Receives the allocations made by Value and the readers.
+
+Allocations are only reported when the library was built with JSON_USE_ALLOCATION_HOOKS set to 1 (the CMake option JSONCPP_WITH_ALLOCATION_HOOKS); otherwise the reporting code is compiled out entirely.
+The observer may be called from every thread that uses the library, so implementations must be thread-safe.
+*/
+class JSON_API AllocationObserver {
+public:
+  virtual ~AllocationObserver();
+  /*!
+  \brief Called after an allocation was made.
+  
+  \param site The code that allocated.
+  \param bytes The number of bytes requested. Map nodes report the size of the element plus the pointers of a typical red-black tree node.
+  */
+  virtual void allocated(AllocationSite site, size_t bytes) = 0;
+};
+
+/*!
+\brief Installs the observer receiving every allocation reported by the library.
+
+The observer must outlive its installation; pass nullptr to remove it.
+
+\param observer The observer to install, or nullptr.
+
+\return True if the library reports allocations, false if it was built without allocation hooks, in which case the observer is never called.
+*/
+JSON_API bool setAllocationObserver(AllocationObserver* observer);
+
+/*!
+\class AllocationCounter
+\brief Counts allocations and bytes per allocation site.
+
+Install a counter with setAllocationObserver(), then read the totals of an operation by calling reset() before it and the accessors after it.
+Counting uses relaxed atomic increments, so one counter may observe several threads.
+*/
+class JSON_API AllocationCounter : public AllocationObserver {
+public:
+  AllocationCounter();
+  void allocated(AllocationSite site, size_t bytes) override;
+  /*!
+  \brief Sets every count back to zero.
+  */
+  void reset();
+  /*!
+  \brief Returns the number of allocations made at a site since the last reset().
+  */
+  size_t count(AllocationSite site) const;
+  /*!
+  \brief Returns the number of bytes allocated at a site since the last reset().
+  */
+  size_t bytes(AllocationSite site) const;
+  /*!
+  \brief Returns the number of allocations made at all sites since the last reset().
+  */
+  size_t totalCount() const;
+  /*!
+  \brief Returns the number of bytes allocated at all sites since the last reset().
+  */
+  size_t totalBytes() const;
+
+private:
+  std::array<std::atomic<size_t>, numberOfAllocationSites> counts_;
+  std::array<std::atomic<size_t>, numberOfAllocationSites> bytes_;
+};
+
+/*!
+\struct MemoryUsage
+\brief Footprint of a value tree, as measured by Value::memoryUsage().
+
+The byte counts are the sizes the library requests for the tree; allocator bookkeeping and alignment padding are not included.
+Every Value is counted once in valueBytes, the root included, so an object member adds sizeof(Value) to valueBytes and the rest of its map node to mapBytes.
+*/
+struct JSON_API MemoryUsage {
+  /// sizeof(Value) for every value in the tree.
+  size_t valueBytes = 0;
+  /// Array and object containers and their nodes, without the values held.
+  size_t mapBytes = 0;
+  /// Member names copied into the objects.
+  size_t keyBytes = 0;
+  /// String values, including their length prefix and terminator.
+  size_t stringBytes = 0;
+  /// Comment storage and the heap buffers of the comment strings.
+  size_t commentBytes = 0;
+  /// Number of values of each ValueType, indexed by the type.
+  size_t countByType[objectValue + 1] = {};
+  /// Number of values, the root included.
+  size_t nodes = 0;
+  /// Deepest nesting of arrays and objects; a scalar root has depth 1.
+  size_t maxDepth = 0;
+  /// Members summed over every object in the tree.
+  size_t objectMembers = 0;
+
+  /*!
+  \brief Returns the sum of all byte counts.
+  */
+  size_t totalBytes() const {
+    return valueBytes + mapBytes + keyBytes + stringBytes + commentBytes;
+  }
+  /*!
+  \brief Returns the average number of members per object, or 0 without objects.
+  */
+  double averageFanOut() const {
+    size_t const objects = countByType[objectValue];
+    return objects ? static_cast<double>(objectMembers) /
+                         static_cast<double>(objects)
+                   : 0.0;
+  }
+};
+
 /*!
 \class Value
 \brief Represents and manipulates JSON data structures.
@@ -191,6 +386,7 @@ Includes features for handling comments and efficient memory management, enablin
 */
 class JSON_API Value {
   friend class ValueIteratorBase;
+  friend class ValueHashCache;
 
 public:
   using Members = std::vector<String>;
@@ -450,6 +646,17 @@ public:
   */
   void swapPayload(Value& other);
 
+  /*!
+  \brief Makes this value the string in [begin, end), reusing its string buffer when possible.
+  
+  Has the same result as swapping in the payload of Value(begin, end), but when this value already owns a string buffer at least as long as the new text, the text is copied into it and nothing is allocated.
+  Readers use it to recycle the strings of a tree they parse into again.
+  
+  \param begin Pointer to the first character of the new string.
+  \param end Pointer one past the last character of the new string.
+  */
+  void assignString(const char* begin, const char* end);
+
   /*!
   \brief Creates a deep copy of another Value object.
   
@@ -498,6 +705,18 @@ public:
   */
   int compare(const Value& other) const;
 
+  /*!
+  \brief Computes a hash of the contents of this value.
+  
+  Values that compare equal with operator== hash equally: the type takes part in the hash just as it does in the comparison, 0.0 and -0.0 hash alike, and comments and offsets are ignored.
+  Members are hashed in key order, so objects built by inserting the same members in any order hash alike.
+  The result depends only on the contents, not on the process, so it may be stored.
+  The tree is walked with an explicit stack; use ValueHashCache to avoid walking unchanged subtrees again.
+  
+  \return The 64-bit hash.
+  */
+  LargestUInt hash() const;
+
   /*!
   \brief Returns the value as a C-style string.
   
@@ -878,6 +1097,22 @@ public:
   \return true if the insertion was successful, false if the index was out of bounds.
   */
   bool insert(ArrayIndex index, Value&& newValue);
+  /*!
+  \brief Inserts a sequence of values at a specified index in the array.
+  
+  Makes room once for all the new values, shifting each later element a single time, so inserting K values costs one pass over the array instead of K.
+  Each new element is assigned from the dereferenced iterator, so a std::move_iterator moves the values in.
+  If the current value is null, it is first converted to an empty array.
+  
+  \param index The position of the first inserted value. Must be less than or equal to the current array size.
+  \param first Iterator to the first value to insert.
+  \param last Iterator past the last value to insert.
+  
+  \return true if the values were inserted, false if the index was out of bounds.
+  */
+  template <typename ForwardIterator>
+  bool insertRange(ArrayIndex index, ForwardIterator first,
+                   ForwardIterator last);
 
   Value& operator[](const char* key);
 
@@ -956,6 +1191,17 @@ public:
   */
   Value const* find(const String& key) const;
 
+  /*!
+  \brief Searches for an element stored in the JSON array.
+  
+  Unlike operator[], this never returns the shared null value: an index below size() that was never assigned, as index 1 after `a[3] = x`, is reported as missing.
+  
+  \param index The zero-based index of the element.
+  
+  \return Pointer to the element if it is stored, nullptr if it is not or if the current value is not an array.
+  */
+  Value const* findIndex(ArrayIndex index) const;
+
   /*!
   \brief Retrieves or creates a nested Value object.
   
@@ -1044,6 +1290,37 @@ public:
   \return True if the element was successfully removed, false if the index was out of range or if the Value is not an array.
   */
   bool removeIndex(ArrayIndex index, Value* removed);
+  /*!
+  \brief Removes the elements in the index range [begin, end) from the array.
+  
+  The later elements are moved down in a single pass and the freed slots are then dropped from the end, so removing many adjacent elements costs the same as removing one.
+  
+  \param begin Index of the first element to remove.
+  \param end Index past the last element to remove; clamped to the array size.
+  
+  \return The number of elements removed, 0 if this value is not an array.
+  */
+  ArrayIndex eraseRange(ArrayIndex begin, ArrayIndex end);
+  /*!
+  \brief Removes every array element for which the predicate returns true.
+  
+  Compacts the array in a single pass, moving each kept element at most once and keeping their order.
+  
+  \param predicate Called once per element, in order, with the element as a const Value&.
+  
+  \return The number of elements removed, 0 if this value is not an array.
+  */
+  template <typename Predicate> ArrayIndex eraseIf(Predicate predicate);
+  /*!
+  \brief Keeps only the array elements for which the predicate returns true.
+  
+  The complement of eraseIf(), with the same single pass.
+  
+  \param predicate Called once per element, in order, with the element as a const Value&.
+  
+  \return The number of elements removed, 0 if this value is not an array.
+  */
+  template <typename Predicate> ArrayIndex retainIf(Predicate predicate);
 
   /*!
   \brief Checks if a member with the specified key exists.
@@ -1200,6 +1477,26 @@ public:
   */
   iterator end();
 
+  /*!
+  \brief Iterates over the members of an object together with their names.
+  
+  Each step yields an ItemRange::Item holding a StringView of the member name and a reference to its value, so reading the names allocates nothing:
+  \code
+  for (auto const& item : root.items())
+    use(item.key, item.value);
+  \endcode
+  For arrays, the names are empty; the iterators of the range also provide index().
+  
+  \return A range over the members, or an empty range for other types.
+  */
+  ItemRange<const_iterator> items() const;
+  /*!
+  \brief Iterates over the members of an object together with their names, allowing the values to be modified.
+  
+  \return A range over the members, or an empty range for other types.
+  */
+  ItemRange<iterator> items();
+
   /*!
   \brief Returns a reference to the first element in the array.
   
@@ -1281,6 +1578,56 @@ public:
   */
   ptrdiff_t getOffsetLimit() const;
 
+  /*!
+  \brief Measures the memory held by this value and everything below it.
+  
+  Walks the whole tree, so the cost is linear in its size.
+  Strings that only point to a StaticString are not counted, since the tree does not own them.
+  
+  \return The byte counts by kind of storage, the number of values of each type, the maximum depth and the object fan-out.
+  */
+  MemoryUsage memoryUsage() const;
+
+  /*!
+  \brief Lets this value keep the bytes it was last serialized to.
+  
+  Once enabled, StreamWriterBuilder writers store the text they produce for this value and splice it into later writes made with the same settings instead of walking the subtree again.
+  Every mutator of this value or of any value below it, such as operator[], append(), removeMember(), swap() or setComment(), discards the stored text of this value and of every enclosing value that also enabled the cache.
+  The cache belongs to this Value object: copies and values moved out of it start without one.
+  While serializations are stored, mutations inside the subtree take a process-wide lock, so the cache suits trees that are written far more often than they change.
+  */
+  void enableSerializationCache();
+  /*!
+  \brief Discards the stored serializations of this value and stops caching them.
+  */
+  void disableSerializationCache();
+  /*!
+  \brief Checks whether enableSerializationCache() was called on this value.
+  
+  \return True if writers may store and reuse the serialization of this value.
+  */
+  bool hasSerializationCache() const { return bits_.cacheRoot_; }
+  /*!
+  \brief Retrieves a serialization stored by a writer.
+  
+  Used by writers; the key describes every setting that affects the bytes produced, including the writer's state when it reaches this value.
+  
+  \param key The writer-defined description of the serialization.
+  \param fragment Receives the stored text when one is found.
+  
+  \return True if a serialization for the key is stored and still valid, false otherwise or if the cache is not enabled.
+  */
+  bool findCachedSerialization(String const& key, String* fragment) const;
+  /*!
+  \brief Stores the serialization of this value for later writes.
+  
+  Used by writers; does nothing if the cache is not enabled for this value.
+  
+  \param key The writer-defined description of the serialization.
+  \param fragment The text written for this value.
+  */
+  void storeCachedSerialization(String const& key, String fragment) const;
+
 private:
   /*!
   \brief Sets the type of the JSON value.
@@ -1311,6 +1658,18 @@ private:
   \param v Boolean value indicating the allocation status to be set.
   */
   void setIsAllocated(bool v) { bits_.allocated_ = v; }
+  /*!
+  \brief Sets the serialization cache domain this value belongs to.
+  
+  Domain numbers are handed out by the cache registry and always fit the bits kept for them.
+  
+  \param domain The cache domain, or 0 for none.
+  */
+  void setCacheDomain(unsigned int domain) {
+    bits_.cacheDomain_ = domain & maxCacheDomain;
+  }
+  /// The cache domain this value belongs to, or 0 for none.
+  unsigned int cacheDomain() const { return bits_.cacheDomain_; }
 
   /*!
   \brief Initializes the basic properties of a Value object.
@@ -1341,6 +1700,22 @@ private:
   */
   void releasePayload();
   /*!
+  \brief Deletes a map together with every array and object below it.
+  
+  Uses an explicit stack instead of recursion, so the depth of the tree does not bound the call stack.
+  
+  \param map The map of an array or object value, which this function takes over.
+  */
+  static void releaseMap(ObjectValues* map);
+  /*!
+  \brief Deep copies another array or object into this value's map pointer.
+  
+  Uses an explicit stack instead of recursion, so the depth of the tree does not bound the call stack.
+  
+  \param other The array or object value to copy.
+  */
+  void dupTree(const Value& other);
+  /*!
   \brief Duplicates metadata from another Value object.
   
   Copies the comments and position information from the given Value object to this one.
@@ -1374,6 +1749,85 @@ private:
   */
   Value& resolveReference(const char* key, const char* end);
 
+  /*!
+  \brief Discards the cached serializations that include this value.
+  
+  Called by every mutator; does nothing unless the value lies inside a subtree that enabled its serialization cache.
+  */
+  void invalidateSerializationCache() {
+    if (cacheDomain() != 0)
+      dropCachedSerializations(cacheDomain());
+  }
+  /*!
+  \brief Discards the serializations cached for a cache domain and for every domain enclosing it.
+  
+  \param domain The cache domain whose serializations must be discarded.
+  */
+  static void dropCachedSerializations(unsigned int domain);
+  /*!
+  \brief Assigns the children of this value to a cache domain.
+  
+  Values below the children are relabelled with an explicit stack, down to values that enabled their own cache, which are attached to the domain instead.
+  Children that already carry the domain are skipped: below a value labelled with a non-zero domain every value carries it too.
+  
+  \param domain The cache domain the children now belong to, or 0 for none.
+  */
+  void labelSerializationCache(unsigned int domain);
+  /*!
+  \brief Brings the cache labels of a new payload in line with this value's cache domain and invalidates the domain.
+  
+  Called after the payload of this value was replaced.
+  */
+  void refreshSerializationCache();
+  /*!
+  \brief Moves a newly inserted child into this value's cache domain and invalidates the domain.
+  
+  \param child The child that was just inserted into this value.
+  */
+  void adoptIntoSerializationCache(Value& child);
+  /*!
+  \brief Adds this value and its subtree to a memory usage report.
+  
+  \param usage The report being filled in by memoryUsage().
+  */
+  void addMemoryUsage(MemoryUsage& usage) const;
+  /*!
+  \brief Computes hash(), reading and storing the hashes of arrays and objects in a memo when one is given.
+  
+  \param memo The hashes already known by address, or nullptr.
+  */
+  LargestUInt
+  computeHash(std::unordered_map<Value const*, LargestUInt>* memo) const;
+  /*!
+  \brief Compares two trees with an explicit stack instead of recursion.
+  
+  \param other The value to compare with.
+  \param equality True when only equality matters: the sign of a non-zero result is then meaningless, which lets strings and keys of different lengths differ without reading them, and reals compare with == so that NaN differs from everything.
+  
+  \return A negative, zero or positive number as this value orders before, like or after other.
+  */
+  int compareTrees(const Value& other, bool equality) const;
+  /*!
+  \brief Makes room for count elements at index in this array.
+  
+  Converts a null value to an empty array, appends count null elements and swaps them down to index, moving every later element once.
+  
+  \return An iterator to the first of the count null elements.
+  */
+  ObjectValues::iterator openArrayGap(ArrayIndex index, ArrayIndex count);
+  /*!
+  \brief Stores a null element at every index of this array that has none.
+  
+  Arrays made by assigning past their end, as in `a[3] = x`, only hold the assigned elements. The in-place edits move elements between neighbouring map entries, so they call this first to make the entries match the array positions.
+  */
+  void fillArrayGaps();
+  /*!
+  \brief Drops the array elements from the given position to the end.
+  
+  \return The number of elements dropped.
+  */
+  ArrayIndex eraseArrayTail(ObjectValues::iterator from);
+
   union ValueHolder {
     LargestInt int_;
     LargestUInt uint_;
@@ -1383,11 +1837,19 @@ private:
     ObjectValues* map_;
   } value_;
 
+  /// Largest cache domain number; the domain shares a word with the type so
+  /// that the serialization cache does not change the size of Value.
+  static constexpr unsigned int maxCacheDomain = 0x3fffff;
+
   struct {
 
     unsigned int value_type_ : 8;
 
     unsigned int allocated_ : 1;
+
+    unsigned int cacheDomain_ : 22;
+
+    unsigned int cacheRoot_ : 1;
   } bits_;
 
   /*!
@@ -1453,6 +1915,10 @@ private:
     \param comment The comment string to be set for the specified slot.
     */
     void set(CommentPlacement slot, String comment);
+    /*!
+    \brief Returns the heap bytes used by the comments, 0 when there are none.
+    */
+    size_t heapBytes() const;
 
   private:
     using Array = std::array<String, numberOfCommentPlacement>;
@@ -1572,6 +2038,118 @@ template <> inline const char* Value::as<const char*>() const {
   return asCString();
 }
 
+/*!
+\class ValueHashCache
+\brief Remembers the hashes of the arrays and objects of trees that no longer change.
+
+Hashing through the cache reuses the hash of every array and object hashed through it before, so hashing the same tree repeatedly, or its subtrees one by one, walks each subtree once.
+Entries are keyed by address: modifying, moving or destroying a value that was hashed through the cache makes its entries stale, so clear() the cache first.
+*/
+class JSON_API ValueHashCache {
+public:
+  /*!
+  \brief Returns value.hash(), using and filling the cache.
+  
+  \param value The value to hash.
+  
+  \return The same hash as value.hash().
+  */
+  LargestUInt hash(Value const& value);
+  /*!
+  \brief Forgets every stored hash.
+  */
+  void clear() { hashes_.clear(); }
+  /*!
+  \brief Returns the number of arrays and objects whose hash is stored.
+  */
+  size_t size() const { return hashes_.size(); }
+
+private:
+  std::unordered_map<Value const*, LargestUInt> hashes_;
+};
+
+/*!
+\struct ReclaimerStats
+\brief Counters describing the queue of a ValueReclaimer.
+*/
+struct JSON_API ReclaimerStats {
+  /// Most trees queued or being freed at once; release() frees on the
+  /// caller beyond it.
+  size_t capacity = 0;
+  /// Trees queued or being freed; never more than capacity.
+  size_t pending = 0;
+  /// Largest number of trees that were pending at once.
+  size_t highWater = 0;
+  /// Trees handed to the background thread.
+  size_t deferred = 0;
+  /// Trees the background thread has freed.
+  size_t reclaimed = 0;
+  /// Trees freed by release() itself, because they owned no container or
+  /// because the queue was full.
+  size_t releasedInline = 0;
+};
+
+/*!
+\class ValueReclaimer
+\brief Frees value trees on a background thread.
+
+Dropping a large tree frees every node, string and comment in it, which can stall a latency-sensitive thread for milliseconds.
+release() instead moves the tree into a bounded queue and returns; a thread started on the first deferred release frees the queued trees in batches.
+When the queue is full the caller frees the tree itself, so memory held by unreleased trees stays bounded and a reclaimer that cannot keep up slows its callers down instead of growing without limit.
+Trees without arrays or objects are cheap to free and are always freed inline.
+All member functions may be called from any thread.
+*/
+class JSON_API ValueReclaimer {
+public:
+  /*!
+  \brief Creates a reclaimer; its thread is only started by the first deferred release.
+  
+  \param capacity The most trees that may wait in the queue, at least 1.
+  */
+  explicit ValueReclaimer(size_t capacity = 64);
+  /*!
+  \brief Frees the trees still queued and stops the background thread.
+  */
+  ~ValueReclaimer();
+  ValueReclaimer(ValueReclaimer const&) = delete;
+  ValueReclaimer& operator=(ValueReclaimer const&) = delete;
+
+  /*!
+  \brief Takes over a tree and frees it later on the background thread.
+  
+  \param value The tree to free; it is left null, and its comments and offsets are freed with the tree.
+  */
+  void release(Value&& value);
+  /*!
+  \brief Blocks until every tree queued before the call has been freed.
+  
+  Trees that other threads release meanwhile are not waited for, so drain() returns even while releases continue.
+  */
+  void drain();
+  /*!
+  \brief Returns a snapshot of the queue counters.
+  */
+  ReclaimerStats stats() const;
+
+  /*!
+  \brief Returns the process-wide reclaimer used by deferredRelease().
+  
+  It is never destroyed, so trees may be released during static destruction; trees still queued at exit are left to the operating system.
+  */
+  static ValueReclaimer& shared();
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+/*!
+\brief Frees a value tree on the shared ValueReclaimer's background thread.
+
+\param value The tree to free; it is left null.
+*/
+JSON_API void deferredRelease(Value&& value);
+
 /*!
 \class PathArgument
 \brief Represents a component of a JSON path for navigation.
@@ -1583,6 +2161,7 @@ Works in conjunction with the Path class to enable efficient navigation and mani
 class JSON_API PathArgument {
 public:
   friend class Path;
+  friend class CompiledPath;
 
   PathArgument();
   /*!
@@ -1727,6 +2306,176 @@ private:
   static void invalidPath(const String& path, int location);
 
   Args args_;
+
+  friend class CompiledPath;
+};
+
+/*!
+\class CompiledPath
+\brief A Path prepared for resolving against many documents.
+
+Stores each member name with its length and hash, so that resolving neither measures nor copies the names, and tells a missing value apart from a null one.
+To resolve a number of paths against the same documents, group them in a CompiledPathSet.
+*/
+class JSON_API CompiledPath {
+public:
+  CompiledPath() = default;
+  /*!
+  \brief Compiles the steps of an existing path.
+  
+  \param path The path to compile.
+  */
+  explicit CompiledPath(const Path& path);
+  /*!
+  \brief Compiles a path written in the syntax of Path, such as ".user.scores[2]".
+  
+  \param path The text of the path; placeholders are not supported.
+  */
+  explicit CompiledPath(const String& path);
+
+  /*!
+  \brief Finds the value the path leads to.
+  
+  \param root The value to start from.
+  
+  \return The value at the end of the path, or nullptr if a step is missing or the value on the way has the wrong type.
+  */
+  Value const* find(const Value& root) const;
+  /*!
+  \brief Resolves the path like Path::resolve().
+  
+  \param root The value to start from.
+  
+  \return The value at the end of the path, or a null value if it does not exist.
+  */
+  const Value& resolve(const Value& root) const;
+
+  /// Returns the number of steps of the path.
+  size_t size() const { return steps_.size(); }
+
+private:
+  friend class CompiledPathSet;
+
+  struct Step {
+    String key;
+    LargestUInt hash{0};
+    ArrayIndex index{0};
+    bool isKey{false};
+
+    /*!
+    \brief Takes this step from node.
+    
+    \return The child reached, or nullptr if node has no such child.
+    */
+    Value const* apply(const Value& node) const;
+    bool operator==(const Step& other) const;
+  };
+
+  std::vector<Step> steps_;
+};
+
+/*!
+\class CompiledPathSet
+\brief Resolves a fixed set of paths against many documents, sharing their common prefixes.
+
+The paths are merged into a tree of steps when the set is built, so a step shared by several paths, such as the ".user" of ".user.name" and ".user.id", is taken once per document.
+Resolving allocates nothing once the calling thread has resolved a set of this size before.
+*/
+class JSON_API CompiledPathSet {
+public:
+  /*!
+  \brief Builds the set from the given paths.
+  
+  \param paths The paths to resolve; the results of resolveMany() follow their order.
+  \param count The number of paths.
+  */
+  CompiledPathSet(CompiledPath const* paths, size_t count);
+  explicit CompiledPathSet(std::vector<CompiledPath> const& paths);
+
+  /*!
+  \brief Resolves every path of the set against root.
+  
+  \param root The document to resolve the paths in.
+  \param out Receives, for each path in order, the value it leads to, or nullptr if it does not exist; it must have room for size() pointers.
+  */
+  void resolveMany(const Value& root, Value const** out) const;
+
+  /// Returns the number of paths in the set.
+  size_t size() const { return pathCount_; }
+
+private:
+  struct Node {
+    CompiledPath::Step step;
+    /// Node whose value this step starts from; the root node is 0.
+    size_t parent{0};
+    /// One past the last node of the subtree of this node, in preorder.
+    size_t subtreeEnd{0};
+    /// Range of ends_ holding the paths that end at this node.
+    size_t firstEnd{0};
+    size_t endCount{0};
+  };
+
+  void build(CompiledPath const* paths, size_t count);
+
+  std::vector<Node> nodes_;
+  std::vector<size_t> ends_;
+  size_t pathCount_{0};
+};
+
+/*!
+\class Pointer
+\brief Evaluates RFC 6901 JSON Pointers, such as "/users/0/name", against a value.
+
+The pointer text is walked in place, one reference token at a time, and "~1" and "~0" are unescaped into a small stack buffer, so resolving allocates nothing unless a token containing escapes is longer than 128 bytes.
+The empty pointer refers to the root; every other pointer starts with '/'.
+Array elements are selected by decimal indices without leading zeros; "-" names the element past the end of an array.
+*/
+class JSON_API Pointer {
+public:
+  /*!
+  \brief Checks the syntax of a pointer.
+  
+  \param pointer The pointer text.
+  
+  \return true if the pointer is empty or starts with '/' and every '~' is followed by '0' or '1'.
+  */
+  static bool isValid(StringView pointer);
+
+  /*!
+  \brief Finds the value a pointer refers to.
+  
+  \param root The document the pointer applies to.
+  \param pointer The pointer text.
+  
+  \return The value referred to, or nullptr if the pointer is invalid or refers to nothing, including an array element that was never assigned.
+  */
+  static Value const* resolve(const Value& root, StringView pointer);
+  static Value* resolve(Value& root, StringView pointer);
+
+  /*!
+  \brief Finds the value a pointer refers to, creating it if needed.
+  
+  Missing object members are added, and an index equal to the array size, or "-", appends an element.
+  A null value on the way becomes an array if the next token is "-" and an object otherwise.
+  Values created before a step fails are kept.
+  
+  \param root The document the pointer applies to.
+  \param pointer The pointer text.
+  
+  \return The value referred to, or nullptr if the pointer is invalid, goes through a scalar or skips array elements.
+  */
+  static Value* make(Value& root, StringView pointer);
+
+  /*!
+  \brief Removes the value a pointer refers to from its object or array.
+  
+  \param root The document the pointer applies to.
+  \param pointer The pointer text; the empty pointer, which refers to root itself, removes nothing.
+  \param removed If not null, receives the removed value.
+  
+  \return true if a value was removed.
+  */
+  static bool remove(Value& root, StringView pointer, Value* removed = nullptr);
 };
 
 /*!
@@ -1784,6 +2533,15 @@ public:
   */
   String name() const;
 
+  /*!
+  \brief Refers to the name of the current member without copying it.
+  
+  The view points into the key stored in the object, so it stays valid until that member is removed or the object is destroyed.
+  
+  \return The name of the current member, or an empty view if iterating over an array; use index() there.
+  */
+  StringView keyView() const;
+
   JSONCPP_DEPRECATED("Use `key = name();` instead.")
   char const* memberName() const;
 
@@ -2035,6 +2793,216 @@ public:
   pointer operator->() const { return const_cast<pointer>(&deref()); }
 };
 
+/*!
+\class ItemRange
+\brief A range over the members of a value, returned by Value::items().
+
+Dereferencing its iterators yields an Item, built on the fly from the underlying iterator, that names the member with a StringView into the stored key.
+*/
+template <typename IteratorT> class ItemRange {
+public:
+  using ValueType =
+      typename std::remove_reference<typename IteratorT::reference>::type;
+
+  /// A member of an object: a view of its name, empty for array elements,
+  /// and its value.
+  struct Item {
+    StringView key;
+    ValueType& value;
+  };
+
+  /// An input iterator: dereferencing returns the Item by value, which the
+  /// forward iterator requirements do not allow.
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Item;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Item;
+
+    iterator() = default;
+    explicit iterator(IteratorT current) : current_(current) {}
+
+    Item operator*() const { return Item{current_.keyView(), *current_}; }
+    iterator& operator++() {
+      ++current_;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator temp(*this);
+      ++current_;
+      return temp;
+    }
+    bool operator==(iterator const& other) const {
+      return current_ == other.current_;
+    }
+    bool operator!=(iterator const& other) const {
+      return current_ != other.current_;
+    }
+
+    /// Returns the position of the current element of an array.
+    ArrayIndex index() const { return current_.index(); }
+
+  private:
+    IteratorT current_;
+  };
+
+  ItemRange(IteratorT begin, IteratorT end) : begin_(begin), end_(end) {}
+
+  iterator begin() const { return iterator(begin_); }
+  iterator end() const { return iterator(end_); }
+
+private:
+  IteratorT begin_;
+  IteratorT end_;
+};
+
+inline ItemRange<Value::const_iterator> Value::items() const {
+  return ItemRange<const_iterator>(begin(), end());
+}
+
+inline ItemRange<Value::iterator> Value::items() {
+  return ItemRange<iterator>(begin(), end());
+}
+
+/*!
+\class ArrayViewIterator
+\brief Random access iterator over the elements collected by a BasicArrayView.
+
+Dereferences to the element itself, so algorithms that move elements around, such as std::sort(), move the values within the array.
+Advancing, subtracting and indexing are constant time.
+*/
+template <typename ValueT> class ArrayViewIterator {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = typename std::remove_const<ValueT>::type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = ValueT*;
+  using reference = ValueT&;
+
+  ArrayViewIterator() = default;
+  explicit ArrayViewIterator(ValueT* const* current) : current_(current) {}
+
+  reference operator*() const { return **current_; }
+  pointer operator->() const { return *current_; }
+  reference operator[](difference_type offset) const {
+    return *current_[offset];
+  }
+
+  ArrayViewIterator& operator++() {
+    ++current_;
+    return *this;
+  }
+  ArrayViewIterator operator++(int) { return ArrayViewIterator(current_++); }
+  ArrayViewIterator& operator--() {
+    --current_;
+    return *this;
+  }
+  ArrayViewIterator operator--(int) { return ArrayViewIterator(current_--); }
+  ArrayViewIterator& operator+=(difference_type offset) {
+    current_ += offset;
+    return *this;
+  }
+  ArrayViewIterator& operator-=(difference_type offset) {
+    current_ -= offset;
+    return *this;
+  }
+  ArrayViewIterator operator+(difference_type offset) const {
+    return ArrayViewIterator(current_ + offset);
+  }
+  friend ArrayViewIterator operator+(difference_type offset,
+                                     ArrayViewIterator it) {
+    return it + offset;
+  }
+  ArrayViewIterator operator-(difference_type offset) const {
+    return ArrayViewIterator(current_ - offset);
+  }
+  difference_type operator-(ArrayViewIterator other) const {
+    return current_ - other.current_;
+  }
+
+  bool operator==(ArrayViewIterator other) const {
+    return current_ == other.current_;
+  }
+  bool operator!=(ArrayViewIterator other) const {
+    return current_ != other.current_;
+  }
+  bool operator<(ArrayViewIterator other) const {
+    return current_ < other.current_;
+  }
+  bool operator>(ArrayViewIterator other) const {
+    return current_ > other.current_;
+  }
+  bool operator<=(ArrayViewIterator other) const {
+    return current_ <= other.current_;
+  }
+  bool operator>=(ArrayViewIterator other) const {
+    return current_ >= other.current_;
+  }
+
+private:
+  ValueT* const* current_{nullptr};
+};
+
+/*!
+\class BasicArrayView
+\brief Gives random access to the elements of an array value.
+
+Arrays keep their elements in a map, so Value::iterator needs linear time for std::distance() and cannot be used where random access is required.
+The view collects the address of every element once, in index order, and then offers constant time indexing and random access iterators over the elements in place, for std::sort(), std::lower_bound() and other algorithms, without copying the values out of the array.
+For an object, the view covers its member values in key order.
+
+Moving elements through the view, for instance by sorting, keeps the view valid.
+Adding or removing elements of the array does not update it; call refresh() afterwards.
+The array must hold an element at every index. Arrays made by assigning past their end, as in `a[3] = x`, lack the skipped ones; assign them, for instance with `a[i] = Value()`, before viewing the array, as refresh() throws a LogicError otherwise.
+
+\code
+Json::ArrayView view(root["scores"]);
+std::sort(view.begin(), view.end());
+\endcode
+*/
+template <typename ValueT> class BasicArrayView {
+public:
+  using iterator = ArrayViewIterator<ValueT>;
+  using size_type = std::size_t;
+
+  /*!
+  \brief Collects the elements of the given array.
+  
+  \param array The array to view; it must outlive the view.
+  */
+  explicit BasicArrayView(ValueT& array) : array_(&array) { refresh(); }
+
+  /*!
+  \brief Collects the elements again, after elements were added to or removed from the array.
+  
+  Throws a LogicError if an index of the array holds no element, since the view positions would then not match the array indices.
+  */
+  void refresh() {
+    elements_.clear();
+    elements_.reserve(array_->size());
+    for (auto& element : *array_)
+      elements_.push_back(&element);
+    if (array_->isArray() && elements_.size() != array_->size())
+      throwLogicError("in Json::BasicArrayView::refresh(): the array has "
+                      "unassigned elements");
+  }
+
+  iterator begin() const { return iterator(elements_.data()); }
+  iterator end() const { return iterator(elements_.data() + elements_.size()); }
+  size_type size() const { return elements_.size(); }
+  bool empty() const { return elements_.empty(); }
+  ValueT& operator[](size_type index) const { return *elements_[index]; }
+
+private:
+  ValueT* array_;
+  std::vector<ValueT*> elements_;
+};
+
+using ArrayView = BasicArrayView<Value>;
+using ConstArrayView = BasicArrayView<Value const>;
+
 /*!
 \brief Swaps the contents of two Json::Value objects.
 
@@ -2070,8 +3038,56 @@ Assumes the Value is a non-empty array.
 */
 inline Value& Value::back() { return *(--end()); }
 
+/*!
+Opens the gap for all the new values at once, then assigns them in order.
+*/
+template <typename ForwardIterator>
+bool Value::insertRange(ArrayIndex index, ForwardIterator first,
+                        ForwardIterator last) {
+  if (index > size())
+    return false;
+  auto slot =
+      openArrayGap(index, static_cast<ArrayIndex>(std::distance(first, last)));
+  for (; first != last; ++first, ++slot)
+    slot->second = *first;
+  return true;
+}
+
+/*!
+Swaps each kept element into the next free slot, so the removed ones collect at the end, where they are dropped together.
+*/
+template <typename Predicate> ArrayIndex Value::eraseIf(Predicate predicate) {
+  if (type() != arrayValue)
+    return 0;
+  fillArrayGaps();
+  auto kept = value_.map_->begin();
+  for (auto it = kept; it != value_.map_->end(); ++it) {
+    if (predicate(static_cast<Value const&>(it->second)))
+      continue;
+    if (kept != it)
+      kept->second.swap(it->second);
+    ++kept;
+  }
+  return eraseArrayTail(kept);
+}
+
+template <typename Predicate> ArrayIndex Value::retainIf(Predicate predicate) {
+  return eraseIf(
+      [&predicate](Value const& element) { return !predicate(element); });
+}
+
 } // namespace Json
 
+namespace std {
+/// Hashes a Json::Value with Json::Value::hash(), so values can be used as
+/// keys of unordered containers.
+template <> struct hash<Json::Value> {
+  size_t operator()(Json::Value const& value) const {
+    return static_cast<size_t>(value.hash());
+  }
+};
+} // namespace std
+
 #pragma pack(pop)
 
 #if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
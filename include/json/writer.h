@@ -20,6 +20,36 @@ namespace Json {
 
 class Value;
 
+/*!
+\struct WriteStats
+\brief Counters and timing collected by a StreamWriter.
+
+Pass an instance to StreamWriterBuilder::newStreamWriter(WriteStats*) to find out what a value tree cost to serialize without attaching a profiler.
+Every call to StreamWriter::write() resets the counters and fills them in as the values are written, so writeNanoseconds includes the counting.
+The counters follow ParseStats: strings includes member names, and holes in a sparse array count as the null literals that are written for them.
+*/
+struct JSON_API WriteStats {
+  /// Bytes added to the stream, or 0 if the stream cannot report its position.
+  size_t bytesWritten = 0;
+  size_t objects = 0;
+  size_t arrays = 0;
+  /// Strings written, member names included.
+  size_t strings = 0;
+  size_t memberNames = 0;
+  size_t integers = 0;
+  size_t reals = 0;
+  /// true, false and null values.
+  size_t literals = 0;
+  /// Escape sequences emitted for strings and member names.
+  size_t escapes = 0;
+  /// Deepest nesting of arrays and objects; a scalar root has depth 1.
+  size_t maxDepth = 0;
+  /// Values written, the root included.
+  size_t nodes = 0;
+  /// Wall-clock nanoseconds spent formatting the output.
+  Int64 writeNanoseconds = 0;
+};
+
 /*!
 \class StreamWriter
 \brief Provides an abstract interface for writing JSON data to output streams.
@@ -123,12 +153,22 @@ public:
   \return A pointer to a newly created StreamWriter object. The caller is responsible for managing the memory of this object.
   */
   StreamWriter* newStreamWriter() const override;
+  /*!
+  \brief Creates a new StreamWriter that collects write counters.
+
+  Every call to write() on the returned writer resets *stats and fills it in while the value is written.
+
+  \param stats The object to fill in, or nullptr to collect nothing. It must outlive the returned writer.
+
+  \return A pointer to a newly created StreamWriter object. The caller is responsible for managing the memory of this object.
+  */
+  StreamWriter* newStreamWriter(WriteStats* stats) const;
 
   /*!
   \brief Validates the current settings of the StreamWriterBuilder.
   
   Checks if all keys in the settings_ member are valid for JSON stream writing.
-  Valid keys include indentation, commentStyle, enableYAMLCompatibility, dropNullPlaceholders, useSpecialFloats, emitUTF8, precision, and precisionType.
+  Valid keys include indentation, commentStyle, enableYAMLCompatibility, dropNullPlaceholders, useSpecialFloats, emitUTF8, precision, precisionType, parallelThreshold, and parallelThreads.
   
   \param invalid A pointer to a Json::Value object that will store any invalid settings found. If null, the function returns false on the first invalid setting encountered.
   
@@ -142,13 +182,187 @@ public:
   \brief Initializes default settings for JSON stream writing.
   
   Populates a Json::Value object with predefined key-value pairs for JSON output configuration.
-  Sets default values for comment style, indentation, YAML compatibility, null placeholders, special floats, UTF-8 encoding, and numerical precision.
+  Sets default values for comment style, indentation, YAML compatibility, null placeholders, special floats, UTF-8 encoding, numerical precision, and parallel serialization.
+  parallelThreshold defaults to 0, which keeps serialization on the calling thread; when set, arrays and objects with at least that many elements are split into chunks written concurrently by parallelThreads threads (0 meaning one per hardware thread), with output identical to a serial write.
   
   \param settings Pointer to a Json::Value object to be populated with default settings.
   */
   static void setDefaults(Json::Value* settings);
 };
 
+/*!
+\brief Computes the length of the text a StreamWriterBuilder would produce for a value.
+
+Walks the tree without formatting anything: integer digits, escaped string lengths, separators, indentation and comments are counted arithmetically.
+The result is exact in compact mode (empty indentation) unless the tree contains real values, whose formatted length is bounded rather than computed.
+With indentation, every array is assumed to be laid out one element per line and every line break to be taken, which yields an upper bound.
+The walk visits every node, so it costs roughly half of an actual write; it is meant for sizing external buffers or frames ahead of time rather than for calling right before every write.
+
+\param root The JSON value to be measured.
+\param builder The builder whose settings_ control the output format.
+
+\return The exact serialized length or an upper bound of it, in bytes.
+*/
+size_t JSON_API serializedSizeHint(Value const& root,
+                                   StreamWriterBuilder const& builder);
+
+/*!
+\class StreamingWriter
+\brief Emits JSON tokens directly to an output stream without building a Value.
+
+Provides an event-style interface (beginObject(), key(), value(), endArray(), ...) for producing large documents whose content is generated on the fly.
+Numbers and strings are formatted exactly as the StreamWriter returned by StreamWriterBuilder::newStreamWriter() would format them, and the builder's indentation, emitUTF8, precision, precisionType, useSpecialFloats, enableYAMLCompatibility and dropNullPlaceholders settings are honored.
+Arrays are always laid out one element per line, as with the default "All" comment style; comments are never written.
+Nesting errors (a value without a key inside an object, mismatched end calls, ...) are reported through JSON_ASSERT_MESSAGE in debug builds only.
+
+\code
+Json::StreamWriterBuilder builder;
+Json::StreamingWriter writer(builder, &std::cout);
+writer.beginObject();
+writer.key("count").value(2);
+writer.key("items").beginArray().value("a").value("b").endArray();
+writer.endObject();
+\endcode
+*/
+class JSON_API StreamingWriter {
+public:
+  /*!
+  \brief Constructs a StreamingWriter using the settings of a builder.
+
+  Reads the formatting settings from the given builder and prepares to write a single JSON document to the output stream.
+  The stream must outlive the writer.
+
+  \param builder The builder whose settings_ control the output format.
+  \param sout Pointer to the output stream receiving the JSON text.
+  */
+  StreamingWriter(StreamWriterBuilder const& builder, OStream* sout);
+  ~StreamingWriter();
+
+  StreamingWriter(StreamingWriter const&) = delete;
+  StreamingWriter& operator=(StreamingWriter const&) = delete;
+
+  /*!
+  \brief Starts a JSON object.
+
+  Begins a new object at the current position, either as the root, as an array element, or as the value of the last key().
+  Nothing is written until the first member or the matching endObject(), so empty objects are emitted as "{}".
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& beginObject();
+  /*!
+  \brief Finishes the innermost JSON object.
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& endObject();
+  /*!
+  \brief Starts a JSON array.
+
+  Begins a new array at the current position.
+  Nothing is written until the first element or the matching endArray(), so empty arrays are emitted as "[]".
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& beginArray();
+  /*!
+  \brief Finishes the innermost JSON array.
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& endArray();
+
+  /*!
+  \brief Writes the name of the next object member.
+
+  Must be called inside an object, and must be followed by exactly one value (or a nested container) before the next key.
+  The name may contain embedded zeroes.
+
+  \param begin Pointer to the first character of the member name.
+  \param end Pointer one past the last character of the member name.
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& key(char const* begin, char const* end);
+  StreamingWriter& key(char const* name);
+  StreamingWriter& key(String const& name);
+
+  /*!
+  \brief Writes a scalar value.
+
+  Writes the value at the current position, either as the root, as an array element, or as the value of the last key().
+
+  \param value The value to be written.
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& value(Int value);
+  StreamingWriter& value(UInt value);
+#if defined(JSON_HAS_INT64)
+  StreamingWriter& value(Int64 value);
+  StreamingWriter& value(UInt64 value);
+#endif
+  StreamingWriter& value(double value);
+  StreamingWriter& value(bool value);
+  StreamingWriter& value(char const* begin, char const* end);
+  StreamingWriter& value(char const* value);
+  StreamingWriter& value(String const& value);
+  /*!
+  \brief Writes an existing Value tree at the current position.
+
+  Allows prebuilt fragments to be mixed with streamed content.
+  The tree is written with the same layout as the streamed tokens; its comments are ignored.
+
+  \param value The tree to be written.
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& value(Value const& value);
+  /*!
+  \brief Writes a null value, or nothing when dropNullPlaceholders is set.
+
+  \return A reference to this writer, allowing calls to be chained.
+  */
+  StreamingWriter& null();
+
+  /*!
+  \brief Checks whether a complete JSON document has been written.
+
+  \return True once the root value, including all of its nested containers, has been closed.
+  */
+  bool isComplete() const;
+
+private:
+  struct Frame {
+    bool isObject;
+    bool opened;
+    ArrayIndex count;
+  };
+
+  void beginValue();
+  void endValue();
+  void beginContainer(bool isObject);
+  void endContainer(bool isObject);
+  void openContainer(Frame& frame);
+  void writeScalar(String const& text);
+  void writeIndent();
+  void writeWithIndent(char const* text, size_t length);
+
+  std::vector<Frame> frames_;
+  OStream* sout_;
+  String indentString_;
+  String indentation_;
+  String colonSymbol_;
+  String nullSymbol_;
+  unsigned int precision_;
+  PrecisionType precisionType_;
+  bool useSpecialFloats_ : 1;
+  bool emitUTF8_ : 1;
+  bool indented_ : 1;
+  bool keyWritten_ : 1;
+  bool complete_ : 1;
+};
+
 /*!
 \class Writer
 \brief Defines an interface for writing JSON data.
@@ -0,0 +1,485 @@
+// Copyright 2007-2010 The JsonCpp Authors
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+/* This executable looks for inputs that make the reader, the writer or the
+ * Value mutators do more than linear work.
+ *
+ * Every input is grown by repetition to two sizes, a factor growthFactor
+ * apart, and the cost of each workload is measured at both. The growth
+ * exponent log(cost ratio) / log(size ratio) is about 1 for linear work and
+ * 2 for quadratic work; inputs above superlinearExponent are reported and,
+ * with --save, copied to a directory so they can be kept as regression
+ * cases in test/complexity.
+ *
+ * The cost is the number of user-space instructions retired where the
+ * hardware counter is available. Unlike wall time, it does not change with
+ * cache misses or machine load, so the check gives the same answer on every
+ * run. Elsewhere the cost is the number of allocations, which repeats
+ * exactly as well but only sees work that allocates: it catches quadratic
+ * copying and buffer growth, not quadratic scanning. Only when a sanitizer
+ * owns the allocator does the cost fall back to wall time, which is good
+ * enough to explore inputs but too noisy to gate on; --counters-only, which
+ * the CTest check uses, skips the run in that case.
+ *
+ * Built with corpus.cpp and counters.cpp, -DJSONCPP_COMPLEXITY_FUZZER and
+ * -fsanitize=fuzzer the same checks run as a libFuzzer target that aborts on
+ * a superlinear input, so libFuzzer keeps it as a crash artifact. The
+ * JSONCPP_WITH_COMPLEXITY_FUZZER CMake option builds it as
+ * jsoncpp_complexity_fuzzer.
+ */
+
+#include "corpus.h"
+#include "counters.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <json/json.h>
+#include <memory>
+#include <sstream>
+
+namespace {
+
+/// Ratio between the large and the small size of every measurement.
+unsigned int const growthFactor = 8;
+/// Growth exponent above which a workload is reported.
+double const superlinearExponent = 1.5;
+/// The small size is grown until one run costs at least this much, so that
+/// fixed overheads and timer resolution do not dominate the ratio.
+double const minimumInstructions = 4e6;
+double const minimumAllocations = 2e4;
+double const minimumSeconds = 0.002;
+/// Upper bound for the repetition count of the small size. Workloads that
+/// stay cheaper than the minimum even then, such as logarithmic map
+/// operations, are not worth reporting.
+unsigned int const maximumRepetitions = 1 << 13;
+
+/// Measures the cost of running a workload once.
+class Meter {
+public:
+  bool countsInstructions() const { return counter_.available(); }
+  bool countsAllocations() const {
+    return !countsInstructions() && JsonBench::allocationsCounted();
+  }
+  /// True unless the cost is wall time.
+  bool repeatable() const {
+    return countsInstructions() || countsAllocations();
+  }
+  double minimumCost() const {
+    if (countsInstructions())
+      return minimumInstructions;
+    return countsAllocations() ? minimumAllocations : minimumSeconds;
+  }
+  double cost(std::function<void()> const& run) {
+    if (countsInstructions()) {
+      counter_.start();
+      run();
+      return static_cast<double>(counter_.stop());
+    }
+    if (countsAllocations()) {
+      size_t const before = JsonBench::allocationCount();
+      run();
+      return static_cast<double>(JsonBench::allocationCount() - before);
+    }
+    using Clock = std::chrono::steady_clock;
+    auto const start = Clock::now();
+    run();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+private:
+  JsonBench::InstructionCounter counter_;
+};
+
+Meter& meter() {
+  static Meter instance;
+  return instance;
+}
+
+/// A workload run on the input repeated a given number of times.
+struct Workload {
+  char const* name;
+  /// Prepares the data for the repetition count; not timed.
+  std::function<void(unsigned int)> setup;
+  std::function<void()> run;
+};
+
+struct Measurement {
+  Json::String workload;
+  unsigned int repetitions;
+  double smallCost;
+  double largeCost;
+
+  double exponent() const {
+    if (smallCost <= 0 || largeCost <= 0)
+      return 0;
+    return std::log(largeCost / smallCost) / std::log(growthFactor);
+  }
+  /// Only runs that cost enough to measure reliably are reported.
+  bool superlinear() const {
+    return largeCost >= meter().minimumCost() * growthFactor &&
+           exponent() > superlinearExponent;
+  }
+};
+
+Json::String repeatedArray(Json::String const& input,
+                           unsigned int repetitions) {
+  Json::String text = "[";
+  text.reserve(repetitions * (input.size() + 1) + 2);
+  for (unsigned int i = 0; i < repetitions; ++i) {
+    if (i)
+      text += ',';
+    text += input;
+  }
+  text += ']';
+  return text;
+}
+
+/// Parses the input on its own; an input that does not parse is used as
+/// the payload of a string value so that the writer still escapes it.
+Json::Value inputValue(Json::String const& input) {
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+  Json::Value value;
+#if JSON_USE_EXCEPTION
+  try {
+#endif
+    if (reader->parse(input.data(), input.data() + input.size(), &value,
+                      nullptr))
+      return value;
+#if JSON_USE_EXCEPTION
+  } catch (std::exception const&) {
+  }
+#endif
+  return Json::Value(input);
+}
+
+/// State shared by the workloads of one input.
+struct Subject {
+  Json::String input;
+  Json::Value value;
+  Json::String text;
+  Json::Value tree;
+  /// Elements moved out of tree by the bulk edit workload.
+  std::vector<Json::Value> parked;
+  volatile size_t sink = 0;
+};
+
+std::vector<Workload> workloads(Subject& subject) {
+  Subject* const s = &subject;
+  auto const makeText = [s](unsigned int repetitions) {
+    s->text = repeatedArray(s->input, repetitions);
+  };
+  auto const makeArray = [s](unsigned int repetitions) {
+    s->tree = Json::Value(Json::arrayValue);
+    for (unsigned int i = 0; i < repetitions; ++i)
+      s->tree.append(s->value);
+  };
+  auto const makeObject = [s](unsigned int repetitions) {
+    s->tree = Json::Value(Json::objectValue);
+    for (unsigned int i = 0; i < repetitions; ++i)
+      s->tree["member" + std::to_string(i)] = s->value;
+  };
+  std::vector<Workload> result;
+
+  // Reading, including the error reporting after a failed parse.
+  result.push_back({"parse", makeText, [s]() {
+                      Json::CharReaderBuilder builder;
+                      builder["collectComments"] = true;
+                      std::unique_ptr<Json::CharReader> const reader(
+                          builder.newCharReader());
+                      Json::Value root;
+                      Json::String errors;
+                      char const* const begin = s->text.data();
+                      reader->parse(begin, begin + s->text.size(), &root,
+                                    &errors);
+                      s->sink = errors.size() +
+                                reader->getStructuredErrors().size();
+                    }});
+  result.push_back({"parse_legacy", makeText, [s]() {
+                      Json::Reader reader;
+                      Json::Value root;
+                      char const* const begin = s->text.data();
+                      reader.parse(begin, begin + s->text.size(), root);
+                      s->sink = reader.getFormattedErrorMessages().size() +
+                                reader.getStructuredErrors().size();
+                    }});
+
+  result.push_back({"write", makeArray, [s]() {
+                      Json::StreamWriterBuilder builder;
+                      s->sink = Json::writeString(builder, s->tree).size();
+                    }});
+  result.push_back({"write_compact", makeArray, [s]() {
+                      Json::StreamWriterBuilder builder;
+                      builder["indentation"] = "";
+                      s->sink = Json::writeString(builder, s->tree).size();
+                    }});
+
+  // Each mutation touches one element, so a fixed number of them must not
+  // cost more than linear time in the size of the container.
+  result.push_back({"insert_remove_index", makeArray, [s]() {
+                      Json::Value removed;
+                      for (int i = 0; i < 16; ++i) {
+                        s->tree.insert(0, s->value);
+                        s->tree.removeIndex(0, &removed);
+                      }
+                    }});
+  result.push_back({"remove_member", makeObject, [s]() {
+                      Json::Value removed;
+                      for (int i = 0; i < 16; ++i) {
+                        Json::String const name = "member" + std::to_string(i);
+                        s->tree.removeMember(name, &removed);
+                        s->tree[name] = removed;
+                      }
+                    }});
+  // Bulk edits touch every element, so a fixed number of them must stay
+  // linear too. The front half is moved to the back rather than copied, so
+  // that the time is spent in the edits and not in copying the values.
+  result.push_back({"bulk_erase_insert", makeArray, [s]() {
+                      size_t const half = s->tree.size() / 2;
+                      for (int i = 0; i < 16; ++i) {
+                        s->parked.clear();
+                        for (auto it = s->tree.begin();
+                             s->parked.size() < half; ++it)
+                          s->parked.push_back(std::move(*it));
+                        size_t position = 0;
+                        s->tree.eraseIf(
+                            [&position, half](Json::Value const&) {
+                              return position++ < half;
+                            });
+                        s->tree.insertRange(
+                            s->tree.size(),
+                            std::make_move_iterator(s->parked.begin()),
+                            std::make_move_iterator(s->parked.end()));
+                      }
+                    }});
+  return result;
+}
+
+/// Returns the lowest cost of three runs.
+double costOfRun(Workload const& workload, unsigned int repetitions) {
+  workload.setup(repetitions);
+  double best = 0;
+  for (int i = 0; i < 3; ++i) {
+    double const cost = meter().cost([&workload]() {
+#if JSON_USE_EXCEPTION
+      try {
+        workload.run();
+      } catch (std::exception const&) {
+      }
+#else
+      workload.run();
+#endif
+    });
+    if (i == 0 || cost < best)
+      best = cost;
+  }
+  return best;
+}
+
+Measurement measureWorkload(Workload const& workload) {
+  Measurement result{workload.name, 1, 0, 0};
+  result.smallCost = costOfRun(workload, 1);
+  while (result.smallCost < meter().minimumCost() &&
+         result.repetitions < maximumRepetitions) {
+    result.repetitions *= 2;
+    result.smallCost = costOfRun(workload, result.repetitions);
+  }
+  result.largeCost = costOfRun(workload, result.repetitions * growthFactor);
+  // A second opinion before reporting, in case the machine was busy.
+  if (result.superlinear() && !meter().repeatable()) {
+    result.smallCost = costOfRun(workload, result.repetitions);
+    result.largeCost =
+        std::min(result.largeCost,
+                 costOfRun(workload, result.repetitions * growthFactor));
+  }
+  return result;
+}
+
+std::vector<Measurement> measure(Json::String const& input) {
+  Subject subject;
+  subject.input = input;
+  subject.value = inputValue(input);
+  std::vector<Measurement> result;
+  for (auto const& workload : workloads(subject))
+    result.push_back(measureWorkload(workload));
+  return result;
+}
+
+} // namespace
+
+#if defined(JSONCPP_COMPLEXITY_FUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  Json::String const input(reinterpret_cast<char const*>(data), size);
+  for (auto const& measurement : measure(input)) {
+    if (measurement.superlinear()) {
+      std::cerr << measurement.workload << " grows with exponent "
+                << measurement.exponent() << std::endl;
+      std::abort();
+    }
+  }
+  return 0;
+}
+
+#else
+
+namespace {
+
+[[noreturn]] void fail(Json::String const& message) {
+  std::cerr << "jsoncpp_complexity: " << message << std::endl;
+  std::exit(2);
+}
+
+struct Options {
+  std::vector<Json::String> paths;
+  Json::String saveDirectory;
+  unsigned int mutations = 0;
+  uint64_t seed = 1;
+  bool countersOnly = false;
+};
+
+Json::String readFile(Json::String const& path) {
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in)
+    fail("cannot read " + path);
+  std::ostringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+/// Applies one random edit: inserting a JSON-significant byte, deleting a
+/// byte, or duplicating a slice.
+Json::String mutate(Json::String input, JsonBench::Random& random) {
+  static char const alphabet[] = "{}[]\",:\\/*\n 0-1eE.truefalsnul'";
+  uint32_t const position =
+      input.empty() ? 0
+                    : random.below(static_cast<uint32_t>(input.size() + 1));
+  switch (random.below(3)) {
+  case 0:
+    input.insert(position, 1, alphabet[random.below(sizeof(alphabet) - 1)]);
+    break;
+  case 1:
+    if (position < input.size())
+      input.erase(position, 1);
+    break;
+  default: {
+    uint32_t const length = random.below(16) + 1;
+    input.insert(position, input.substr(position, length));
+  } break;
+  }
+  return input;
+}
+
+/// Prints the measurements of one input; returns true if one is
+/// superlinear, after saving the input when a directory was given.
+bool report(Json::String const& label, Json::String const& input,
+            Options const& options) {
+  bool superlinear = false;
+  for (auto const& measurement : measure(input)) {
+    char line[160];
+    snprintf(line, sizeof(line), "%-5s %-40.40s %-20s x%-6u exponent %.2f",
+             measurement.superlinear() ? "SLOW" : "ok", label.c_str(),
+             measurement.workload.c_str(), measurement.repetitions,
+             measurement.exponent());
+    std::cout << line << std::endl;
+    superlinear = superlinear || measurement.superlinear();
+  }
+  if (superlinear && !options.saveDirectory.empty()) {
+    char name[32];
+    snprintf(name, sizeof(name), "slow-%016llx.json",
+             static_cast<unsigned long long>(JsonBench::fnv1a(input)));
+    Json::String const path = options.saveDirectory + "/" + name;
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << input;
+    if (!out)
+      fail("cannot write " + path);
+    std::cout << "saved " << path << std::endl;
+  }
+  return superlinear;
+}
+
+void printUsage(char const* program) {
+  std::cout << "Usage: " << program
+            << " [--save DIR] [--mutations N] [--seed N] [--counters-only] "
+               "FILE...\n"
+               "Reports the workloads whose cost grows faster than "
+               "linearly with the size of each input. --mutations also "
+               "measures N random edits of every input. --counters-only "
+               "exits with status 77 instead of falling back to wall time "
+               "when neither instructions nor allocations can be "
+               "counted.\n";
+}
+
+bool parseUnsigned(char const* text, uint64_t& value) {
+  char* end = nullptr;
+  value = std::strtoull(text, &end, 10);
+  return end != text && *end == 0;
+}
+
+} // namespace
+
+int main(int argc, char const* argv[]) {
+  Options options;
+  for (int index = 1; index < argc; ++index) {
+    Json::String const arg = argv[index];
+    uint64_t number = 0;
+    if (arg == "--help" || arg == "-h") {
+      printUsage(argv[0]);
+      return 0;
+    } else if (arg == "--counters-only") {
+      options.countersOnly = true;
+    } else if (arg == "--save" && index + 1 < argc) {
+      options.saveDirectory = argv[++index];
+    } else if (arg == "--mutations" && index + 1 < argc &&
+               parseUnsigned(argv[index + 1], number) && number <= 1000000) {
+      options.mutations = static_cast<unsigned int>(number);
+      ++index;
+    } else if (arg == "--seed" && index + 1 < argc &&
+               parseUnsigned(argv[index + 1], number)) {
+      options.seed = number;
+      ++index;
+    } else if (!arg.empty() && arg[0] != '-') {
+      options.paths.push_back(arg);
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (options.paths.empty()) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  if (meter().countsAllocations()) {
+    std::cout << "instruction counter unavailable; counting allocations"
+              << std::endl;
+  } else if (!meter().countsInstructions()) {
+    if (options.countersOnly) {
+      std::cout << "no counter available; skipping" << std::endl;
+      return 77;
+    }
+    std::cout << "no counter available; timing instead" << std::endl;
+  }
+
+  JsonBench::Random random(options.seed);
+  int slow = 0;
+  for (auto const& path : options.paths) {
+    Json::String const input = readFile(path);
+    slow += report(path, input, options);
+    Json::String mutated = input;
+    for (unsigned int i = 0; i < options.mutations; ++i) {
+      mutated = mutate(mutated, random);
+      slow += report(path + " #" + std::to_string(i + 1), mutated, options);
+    }
+  }
+  return slow ? 1 : 0;
+}
+
+#endif
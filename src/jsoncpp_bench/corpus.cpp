@@ -0,0 +1,200 @@
+// Copyright 2007-2010 The JsonCpp Authors
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#include "corpus.h"
+#include <cstdio>
+
+namespace JsonBench {
+
+uint64_t Random::next() {
+  state_ ^= state_ >> 12;
+  state_ ^= state_ << 25;
+  state_ ^= state_ >> 27;
+  return state_ * 0x2545f4914f6cdd1d;
+}
+
+uint64_t fnv1a(Json::String const& text) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+static void appendInteger(Json::String& out, int64_t value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+  out += buffer;
+}
+
+// Reals are written with a fixed number of digits so that the text does not
+// depend on the platform's shortest round-trip formatting.
+static void appendReal(Json::String& out, Random& random) {
+  char buffer[32];
+  double const mantissa =
+      static_cast<double>(random.below(1000000)) / 1000.0 - 500.0;
+  int const exponent = static_cast<int>(random.below(41)) - 20;
+  snprintf(buffer, sizeof(buffer), "%.6fe%d", mantissa, exponent);
+  out += buffer;
+}
+
+static void appendString(Json::String& out, Random& random,
+                         unsigned int maxLength) {
+  static char const* const pieces[] = {
+      "a",     "b",  "c",  "d",  "e",  "f",      "g",      "h",
+      "i",     "j",  "k",  "l",  "m",  "n",      "o",      "p",
+      "0",     "1",  "2",  "3",  " ",  " ",      "-",      "_",
+      "\\n",   "\\t", "\\\"", "\\\\", "\\/", "\\u00e9", "\xc3\xa9", "\xe2\x82\xac"};
+  uint32_t const length = 1 + random.below(maxLength);
+  out += '"';
+  for (uint32_t i = 0; i < length; ++i) {
+    // Escapes and multi-byte characters are rarer than plain letters.
+    uint32_t piece = random.below(24);
+    if (random.below(8) == 0)
+      piece = random.below(sizeof(pieces) / sizeof(pieces[0]));
+    out += pieces[piece];
+  }
+  out += '"';
+}
+
+static Json::String numericDocument(Random& random, unsigned int scale) {
+  Json::String out = "[";
+  uint32_t const count = 60000 * scale;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (i)
+      out += ',';
+    switch (random.below(4)) {
+    case 0:
+      appendInteger(out, static_cast<int64_t>(random.below(1000)));
+      break;
+    case 1:
+      appendInteger(out, static_cast<int64_t>(random.next() >> 1) *
+                             (random.below(2) ? 1 : -1));
+      break;
+    default:
+      appendReal(out, random);
+      break;
+    }
+  }
+  out += "]";
+  return out;
+}
+
+static Json::String stringsDocument(Random& random, unsigned int scale) {
+  Json::String out = "[";
+  uint32_t const count = 20000 * scale;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (i)
+      out += ',';
+    appendString(out, random, 80);
+  }
+  out += "]";
+  return out;
+}
+
+// Nesting stays well below the default stackLimit of the CharReaderBuilder.
+static Json::String deepDocument(Random& random, unsigned int scale) {
+  Json::String out = "[";
+  uint32_t const count = 100 * scale;
+  unsigned int const depth = 300;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (i)
+      out += ',';
+    for (unsigned int level = 0; level < depth; ++level)
+      out += (level % 2) ? "[" : "{\"child\":";
+    appendInteger(out, static_cast<int64_t>(random.below(100)));
+    for (unsigned int level = depth; level-- > 0;)
+      out += (level % 2) ? "]" : "}";
+  }
+  out += "]";
+  return out;
+}
+
+static Json::String wideDocument(Random& random, unsigned int scale) {
+  Json::String out = "{";
+  uint32_t const count = 40000 * scale;
+  char key[32];
+  for (uint32_t i = 0; i < count; ++i) {
+    if (i)
+      out += ',';
+    snprintf(key, sizeof(key), "\"key_%08x_%u\":",
+             static_cast<unsigned int>(random.next()), i);
+    out += key;
+    if (random.below(2))
+      appendInteger(out, static_cast<int64_t>(random.below(100000)));
+    else
+      appendString(out, random, 8);
+  }
+  out += "}";
+  return out;
+}
+
+static Json::String recordsDocument(Random& random, unsigned int scale) {
+  static char const* const cities[] = {"Amsterdam", "Berlin", "Lisbon",
+                                       "Oslo", "Z\xc3\xbcrich"};
+  Json::String out = "[";
+  uint32_t const count = 4000 * scale;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (i)
+      out += ',';
+    out += "{\"id\":";
+    appendInteger(out, static_cast<int64_t>(i));
+    out += ",\"name\":";
+    appendString(out, random, 16);
+    out += ",\"email\":";
+    appendString(out, random, 24);
+    out += ",\"active\":";
+    out += random.below(2) ? "true" : "false";
+    out += ",\"score\":";
+    appendReal(out, random);
+    out += ",\"tags\":[";
+    for (uint32_t tag = random.below(5); tag > 0; --tag) {
+      appendString(out, random, 8);
+      if (tag > 1)
+        out += ',';
+    }
+    out += "],\"address\":{\"street\":";
+    appendString(out, random, 20);
+    out += ",\"city\":\"";
+    out += cities[random.below(5)];
+    out += "\",\"zip\":";
+    appendInteger(out, static_cast<int64_t>(10000 + random.below(90000)));
+    out += "},\"manager\":";
+    if (random.below(3))
+      appendInteger(out, static_cast<int64_t>(random.below(count)));
+    else
+      out += "null";
+    out += "}";
+  }
+  out += "]";
+  return out;
+}
+
+std::vector<Document> generateCorpus(uint64_t seed, unsigned int scale) {
+  using Generator = Json::String (*)(Random&, unsigned int);
+  static struct {
+    char const* name;
+    Generator generate;
+  } const shapes[] = {{"numeric", numericDocument},
+                      {"strings", stringsDocument},
+                      {"deep", deepDocument},
+                      {"wide", wideDocument},
+                      {"records", recordsDocument}};
+  std::vector<Document> corpus;
+  for (auto const& shape : shapes) {
+    // Each shape has its own stream, so adding a shape later does not
+    // change the documents generated for the others.
+    Random random(seed ^ fnv1a(shape.name));
+    Document document;
+    document.name = shape.name;
+    document.text = shape.generate(random, scale);
+    document.checksum = fnv1a(document.text);
+    corpus.push_back(std::move(document));
+  }
+  return corpus;
+}
+
+} // namespace JsonBench
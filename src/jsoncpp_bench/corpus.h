@@ -0,0 +1,53 @@
+// Copyright 2007-2010 The JsonCpp Authors
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef JSONCPP_BENCH_CORPUS_H_INCLUDED
+#define JSONCPP_BENCH_CORPUS_H_INCLUDED
+
+#include <cstdint>
+#include <json/config.h>
+#include <vector>
+
+/** \brief Benchmark corpus generated from a seed.
+ *
+ * Every document is produced as text by a small xorshift generator, not by
+ * the library's writer, so the bytes only depend on the seed and the scale
+ * and stay identical between library versions being compared.
+ */
+namespace JsonBench {
+
+struct Document {
+  /// Shape name, used as the suffix of the benchmark names.
+  Json::String name;
+  Json::String text;
+  /// FNV-1a hash of text, reported so results are only compared when they
+  /// were measured on the same bytes.
+  uint64_t checksum;
+};
+
+/// Deterministic pseudo random numbers (xorshift64*).
+class Random {
+public:
+  explicit Random(uint64_t seed) : state_(seed ? seed : 0x9e3779b97f4a7c15) {}
+  uint64_t next();
+  /// Returns a number in [0, bound).
+  uint32_t below(uint32_t bound) {
+    return static_cast<uint32_t>(next() % bound);
+  }
+
+private:
+  uint64_t state_;
+};
+
+/// Generates the numeric, strings, deep, wide and records documents.
+/// \param scale Multiplies the size of every document; 1 gives roughly
+///              1 MB per document except the deep one.
+std::vector<Document> generateCorpus(uint64_t seed, unsigned int scale);
+
+uint64_t fnv1a(Json::String const& text);
+
+} // namespace JsonBench
+
+#endif // ifndef JSONCPP_BENCH_CORPUS_H_INCLUDED
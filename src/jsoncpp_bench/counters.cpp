@@ -0,0 +1,151 @@
+// Copyright 2007-2010 The JsonCpp Authors
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#include "counters.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static std::atomic<size_t> allocations(0);
+static std::atomic<bool> counting(true);
+
+static void countAllocation() {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define JSONCPP_BENCH_SANITIZED 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define JSONCPP_BENCH_SANITIZED 1
+#endif
+
+#if defined(JSONCPP_BENCH_SANITIZED)
+// The sanitizer runtime owns the allocator entry points, so allocations
+// are not counted and the complexity check measures instructions or time.
+#elif defined(__GLIBC__)
+// The library allocates string payloads with malloc(), so with glibc the
+// allocator entry points themselves are counted; operator new ends up here
+// as well.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) noexcept {
+  countAllocation();
+  return __libc_malloc(size);
+}
+void* calloc(size_t count, size_t size) noexcept {
+  countAllocation();
+  return __libc_calloc(count, size);
+}
+void* realloc(void* p, size_t size) noexcept {
+  countAllocation();
+  return __libc_realloc(p, size);
+}
+}
+#else
+// Elsewhere only operator new is counted, which misses the string payloads.
+void* operator new(std::size_t size) {
+  countAllocation();
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+namespace JsonBench {
+
+size_t allocationCount() { return allocations.load(); }
+
+bool allocationsCounted() {
+#if defined(JSONCPP_BENCH_SANITIZED)
+  return false;
+#else
+  return true;
+#endif
+}
+
+void countAllocations(bool enabled) { counting.store(enabled); }
+
+#if defined(__linux__)
+InstructionCounter::InstructionCounter() {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+InstructionCounter::~InstructionCounter() {
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+void InstructionCounter::start() {
+  if (fd_ < 0)
+    return;
+  ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+  ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+uint64_t InstructionCounter::stop() {
+  if (fd_ < 0)
+    return 0;
+  ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+  uint64_t count = 0;
+  if (read(fd_, &count, sizeof(count)) != sizeof(count))
+    return 0;
+  return count;
+}
+#else
+InstructionCounter::InstructionCounter() : fd_(-1) {}
+InstructionCounter::~InstructionCounter() = default;
+void InstructionCounter::start() {}
+uint64_t InstructionCounter::stop() { return 0; }
+#endif
+
+Json::String platformName() {
+#if defined(__linux__)
+  Json::String name = "linux";
+#elif defined(__APPLE__)
+  Json::String name = "macos";
+#elif defined(_WIN32)
+  Json::String name = "windows";
+#else
+  Json::String name = "unknown";
+#endif
+#if defined(_LIBCPP_VERSION)
+  name += "-libc++";
+#elif defined(__GLIBCXX__)
+  name += "-libstdc++";
+#elif defined(_MSC_VER)
+  name += "-msvc";
+#else
+  name += "-unknown";
+#endif
+  name += sizeof(void*) == 8 ? "-64" : "-32";
+  return name;
+}
+
+} // namespace JsonBench
@@ -0,0 +1,59 @@
+// Copyright 2007-2010 The JsonCpp Authors
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef JSONCPP_BENCH_COUNTERS_H_INCLUDED
+#define JSONCPP_BENCH_COUNTERS_H_INCLUDED
+
+#include <cstdint>
+#include <json/config.h>
+
+/** \brief Counter based metrics that, unlike wall time, repeat exactly.
+ *
+ * The performance regression check compares these against the baselines
+ * committed under src/jsoncpp_bench/baselines.
+ */
+namespace JsonBench {
+
+/// Number of allocations made by the process so far. With glibc, calls to
+/// malloc(), calloc() and realloc() are counted; elsewhere only calls to the
+/// global operator new, which the benchmark replaces to count them.
+size_t allocationCount();
+
+/// False when a sanitizer owns the allocator entry points, in which case
+/// allocationCount() stays at 0.
+bool allocationsCounted();
+
+/// Turns the allocation counting on or off; it is on when the process
+/// starts. Programs that only count in one mode turn it off otherwise, so
+/// the replaced allocator then costs a single relaxed load per call.
+void countAllocations(bool enabled);
+
+/// Counts the user-space instructions retired by the calling thread, using
+/// perf_event_open() on Linux. On other systems, or when the kernel does not
+/// expose the hardware counter, available() is false.
+class InstructionCounter {
+public:
+  InstructionCounter();
+  ~InstructionCounter();
+  InstructionCounter(InstructionCounter const&) = delete;
+  InstructionCounter& operator=(InstructionCounter const&) = delete;
+
+  bool available() const { return fd_ >= 0; }
+  void start();
+  /// Returns the instructions retired since start().
+  uint64_t stop();
+
+private:
+  int fd_;
+};
+
+/// Names the platform the baselines apply to, such as "linux-libstdc++-64".
+/// Allocation counts depend on the standard library, so it is part of the
+/// name.
+Json::String platformName();
+
+} // namespace JsonBench
+
+#endif // ifndef JSONCPP_BENCH_COUNTERS_H_INCLUDED
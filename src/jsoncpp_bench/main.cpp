@@ -0,0 +1,507 @@
+// Copyright 2007-2010 The JsonCpp Authors
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+/* This executable measures the parser, the writer and Value operations on a
+ * generated corpus and prints the results as JSON. With --check it instead
+ * compares allocation and instruction counts against committed baselines.
+ */
+
+#include "corpus.h"
+#include "counters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <json/json.h>
+#include <limits>
+#include <memory>
+
+namespace {
+
+struct Options {
+  uint64_t seed = 1;
+  unsigned int scale = 1;
+  unsigned int iterations = 10;
+  Json::String filter;
+  Json::String outputPath;
+  Json::String checkDirectory;
+  Json::String updateDirectory;
+  bool list = false;
+};
+
+/// Exit code CTest is told to report as a skipped test.
+int const skipExitCode = 77;
+
+/// Operations whose counters are compared against the baselines.
+char const* const checkedOperations[] = {"parse", "write", "write_compact",
+                                         "copy", "lookup"};
+
+/// Relative increase over the baseline that fails the check, unless the
+/// baseline file sets its own.
+double const defaultAllocationTolerance = 0.2;
+double const defaultInstructionTolerance = 0.5;
+
+/// A measured operation. setup() runs before every sample and is not timed.
+struct Benchmark {
+  Json::String operation;
+  Json::String shape;
+  /// Bytes of JSON text processed by one run, or 0 when throughput does not
+  /// apply.
+  size_t bytes;
+  std::function<void()> setup;
+  std::function<void()> run;
+
+  Json::String name() const { return operation + "/" + shape; }
+};
+
+/// Keeps results alive so that the measured work cannot be optimized away.
+volatile size_t sink;
+
+/// One member name or array index to look up in a parent value.
+struct Lookup {
+  Json::Value const* parent;
+  Json::String key;
+  Json::ArrayIndex index;
+};
+
+std::vector<Lookup> collectLookups(Json::Value const& root, size_t limit) {
+  std::vector<Lookup> lookups;
+  std::vector<Json::Value const*> pending{&root};
+  while (!pending.empty() && lookups.size() < limit) {
+    Json::Value const* value = pending.back();
+    pending.pop_back();
+    if (value->isObject()) {
+      for (auto it = value->begin(); it != value->end(); ++it) {
+        lookups.push_back({value, it.name(), 0});
+        pending.push_back(&*it);
+      }
+    } else if (value->isArray()) {
+      for (Json::ArrayIndex index = 0; index < value->size(); ++index) {
+        lookups.push_back({value, Json::String(), index});
+        pending.push_back(&(*value)[index]);
+      }
+    }
+  }
+  return lookups;
+}
+
+[[noreturn]] void fail(Json::String const& message) {
+  std::cerr << "jsoncpp_bench: " << message << std::endl;
+  std::exit(1);
+}
+
+/// State shared by the benchmarks of one corpus document.
+struct Fixture {
+  Json::String const* text;
+  Json::Value root;
+  Json::Value equalCopy;
+  Json::Value scratch;
+  std::unique_ptr<Json::Value> victim;
+  Json::String output;
+  std::vector<Lookup> lookups;
+};
+
+void addBenchmarks(std::vector<Benchmark>& benchmarks,
+                   JsonBench::Document const& document, Fixture& fixture) {
+  Json::CharReaderBuilder readerBuilder;
+  std::shared_ptr<Json::CharReader> const reader(
+      readerBuilder.newCharReader());
+  Json::String errors;
+  char const* const begin = document.text.data();
+  char const* const end = begin + document.text.size();
+  if (!reader->parse(begin, end, &fixture.root, &errors))
+    fail("corpus document " + document.name + " does not parse: " + errors);
+  fixture.text = &document.text;
+  fixture.equalCopy = fixture.root;
+  fixture.lookups = collectLookups(fixture.root, 200000);
+
+  Fixture* const f = &fixture;
+  Json::String const& shape = document.name;
+  size_t const bytes = document.text.size();
+  auto resetScratch = [f]() { f->scratch = Json::Value(); };
+  auto clearOutput = [f]() { Json::String().swap(f->output); };
+
+  benchmarks.push_back({"parse", shape, bytes, resetScratch, [f, reader]() {
+                          Json::String errs;
+                          char const* text = f->text->data();
+                          reader->parse(text, text + f->text->size(),
+                                        &f->scratch, &errs);
+                        }});
+
+  Json::StreamWriterBuilder styled;
+  benchmarks.push_back({"write", shape, bytes, clearOutput, [f, styled]() {
+                          f->output = Json::writeString(styled, f->root);
+                          sink = f->output.size();
+                        }});
+  Json::StreamWriterBuilder compact;
+  compact["indentation"] = "";
+  benchmarks.push_back({"write_compact", shape, bytes, clearOutput,
+                        [f, compact]() {
+                          f->output = Json::writeString(compact, f->root);
+                          sink = f->output.size();
+                        }});
+
+  benchmarks.push_back({"copy", shape, 0, resetScratch,
+                        [f]() { f->scratch = f->root; }});
+
+  benchmarks.push_back({"compare", shape, 0, nullptr, [f]() {
+                          if (!(f->root == f->equalCopy))
+                            fail("copies compare unequal");
+                        }});
+
+  benchmarks.push_back({"hash", shape, 0, nullptr,
+                        [f]() { sink = size_t(f->root.hash()); }});
+
+  benchmarks.push_back({"lookup", shape, 0, nullptr, [f]() {
+                          size_t found = 0;
+                          for (auto const& lookup : f->lookups) {
+                            if (lookup.parent->isObject()) {
+                              found += lookup.parent->find(
+                                           lookup.key.data(),
+                                           lookup.key.data() +
+                                               lookup.key.size()) != nullptr;
+                            } else {
+                              found += !(*lookup.parent)[lookup.index].isNull();
+                            }
+                          }
+                          sink = found;
+                        }});
+
+  benchmarks.push_back({"destroy", shape, 0,
+                        [f]() { f->victim.reset(new Json::Value(f->root)); },
+                        [f]() { f->victim.reset(); }});
+}
+
+Json::Value measure(Benchmark const& benchmark, unsigned int iterations) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> samples;
+  samples.reserve(iterations);
+  // The first run warms caches and the allocator and is not recorded.
+  for (unsigned int i = 0; i <= iterations; ++i) {
+    if (benchmark.setup)
+      benchmark.setup();
+    auto const start = Clock::now();
+    benchmark.run();
+    auto const stop = Clock::now();
+    if (i != 0)
+      samples.push_back(
+          std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+  double const median = samples[samples.size() / 2];
+
+  Json::Value result;
+  result["name"] = benchmark.name();
+  result["operation"] = benchmark.operation;
+  result["shape"] = benchmark.shape;
+  result["iterations"] = iterations;
+  result["min_ns"] = samples.front();
+  result["median_ns"] = median;
+  result["mean_ns"] = total / static_cast<double>(samples.size());
+  result["max_ns"] = samples.back();
+  if (benchmark.bytes != 0) {
+    result["bytes"] = Json::UInt64(benchmark.bytes);
+    result["mb_per_second"] =
+        static_cast<double>(benchmark.bytes) / 1e6 / (median / 1e9);
+  }
+  return result;
+}
+
+/// Counters of one run; instructions is 0 when they cannot be counted.
+struct Counters {
+  size_t allocations;
+  uint64_t instructions;
+};
+
+/// Runs a benchmark once to warm up, then keeps the lowest counts of three
+/// runs so that a stray allocation or interrupt does not fail the check.
+Counters countRun(Benchmark const& benchmark,
+                  JsonBench::InstructionCounter& instructionCounter) {
+  if (benchmark.setup)
+    benchmark.setup();
+  benchmark.run();
+  Counters best{std::numeric_limits<size_t>::max(),
+                std::numeric_limits<uint64_t>::max()};
+  for (int i = 0; i < 3; ++i) {
+    if (benchmark.setup)
+      benchmark.setup();
+    size_t const allocationsBefore = JsonBench::allocationCount();
+    instructionCounter.start();
+    benchmark.run();
+    uint64_t const instructions = instructionCounter.stop();
+    size_t const allocations = JsonBench::allocationCount() - allocationsBefore;
+    best.allocations = std::min(best.allocations, allocations);
+    best.instructions = std::min(best.instructions, instructions);
+  }
+  return best;
+}
+
+/// Instruction counts are only meaningful for optimized builds.
+bool countsInstructions(JsonBench::InstructionCounter const& counter) {
+#if defined(NDEBUG)
+  return counter.available();
+#else
+  static_cast<void>(counter);
+  return false;
+#endif
+}
+
+bool isCheckedOperation(Json::String const& operation) {
+  for (char const* checked : checkedOperations) {
+    if (operation == checked)
+      return true;
+  }
+  return false;
+}
+
+Json::String baselinePath(Json::String const& directory) {
+  return directory + "/" + JsonBench::platformName() + ".json";
+}
+
+void printUsage(char const* program) {
+  std::cout
+      << "Usage: " << program
+      << " [--seed N] [--scale N] [--iterations N] [--filter TEXT]"
+         " [--out FILE] [--list]\n"
+         "       "
+      << program
+      << " --check DIR | --update-baseline DIR\n"
+         "Runs the benchmarks whose name (operation/shape) contains "
+         "TEXT and prints the results as JSON.\n"
+         "--check compares the allocation and instruction counts of the "
+         "parse, write, copy and lookup benchmarks with DIR/<platform>.json "
+         "and fails on a regression; --update-baseline rewrites that file.\n";
+}
+
+bool parseUnsigned(char const* text, uint64_t& value) {
+  char* end = nullptr;
+  value = std::strtoull(text, &end, 10);
+  return end != text && *end == 0;
+}
+
+int parseCommandLine(int argc, char const* argv[], Options& options) {
+  for (int index = 1; index < argc; ++index) {
+    Json::String const arg = argv[index];
+    if (arg == "--help" || arg == "-h") {
+      printUsage(argv[0]);
+      return 0;
+    }
+    if (arg == "--list") {
+      options.list = true;
+      continue;
+    }
+    if (index + 1 == argc) {
+      printUsage(argv[0]);
+      return 2;
+    }
+    char const* const param = argv[++index];
+    uint64_t number = 0;
+    if (arg == "--filter") {
+      options.filter = param;
+    } else if (arg == "--check") {
+      options.checkDirectory = param;
+    } else if (arg == "--update-baseline") {
+      options.updateDirectory = param;
+    } else if (arg == "--out") {
+      options.outputPath = param;
+    } else if (arg == "--seed" && parseUnsigned(param, number)) {
+      options.seed = number;
+    } else if (arg == "--scale" && parseUnsigned(param, number) &&
+               number > 0 && number <= 1000) {
+      options.scale = static_cast<unsigned int>(number);
+    } else if (arg == "--iterations" && parseUnsigned(param, number) &&
+               number > 0 && number <= 1000000) {
+      options.iterations = static_cast<unsigned int>(number);
+    } else {
+      std::cerr << "Invalid argument: " << arg << " " << param << "\n";
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  return -1;
+}
+
+/// The corpus and the benchmarks measured on it.
+struct Suite {
+  std::vector<JsonBench::Document> corpus;
+  std::vector<std::unique_ptr<Fixture>> fixtures;
+  std::vector<Benchmark> benchmarks;
+
+  Suite(uint64_t seed, unsigned int scale)
+      : corpus(JsonBench::generateCorpus(seed, scale)) {
+    for (auto const& document : corpus) {
+      fixtures.emplace_back(new Fixture());
+      addBenchmarks(benchmarks, document, *fixtures.back());
+    }
+  }
+
+  Benchmark const* find(Json::String const& name) const {
+    for (auto const& benchmark : benchmarks) {
+      if (benchmark.name() == name)
+        return &benchmark;
+    }
+    return nullptr;
+  }
+};
+
+/// Compares the counters of the benchmarks listed in the platform's
+/// baseline file, using the seed and scale recorded there.
+int checkBaseline(Options const& options) {
+  Json::String const path = baselinePath(options.checkDirectory);
+  std::ifstream in(path.c_str());
+  if (!in) {
+    std::cout << "No baseline for " << JsonBench::platformName() << " ("
+              << path << "), skipping." << std::endl;
+    return skipExitCode;
+  }
+  Json::CharReaderBuilder readerBuilder;
+  Json::Value baseline;
+  Json::String errors;
+  if (!Json::parseFromStream(readerBuilder, in, &baseline, &errors))
+    fail("cannot parse " + path + ": " + errors);
+
+  Suite const suite(baseline["seed"].asUInt64(), baseline["scale"].asUInt());
+  double const allocationTolerance =
+      baseline["tolerance"].get("allocations", defaultAllocationTolerance)
+          .asDouble();
+  double const instructionTolerance =
+      baseline["tolerance"].get("instructions", defaultInstructionTolerance)
+          .asDouble();
+  JsonBench::InstructionCounter instructionCounter;
+  bool const instructions = countsInstructions(instructionCounter);
+  if (!instructions)
+    std::cout << "Instruction counts unavailable; checking allocations only."
+              << std::endl;
+
+  int failures = 0;
+  auto const compare = [&failures](Json::String const& name,
+                                   char const* metric, double measured,
+                                   double expected, double tolerance) {
+    bool const regressed = measured > expected * (1 + tolerance);
+    std::cout << (regressed ? "FAIL " : "ok   ") << name << " " << metric
+              << ": " << measured << " (baseline " << expected << ")"
+              << std::endl;
+    failures += regressed;
+  };
+  Json::Value const& expected = baseline["benchmarks"];
+  for (auto it = expected.begin(); it != expected.end(); ++it) {
+    Json::String const name = it.name();
+    if (name.find(options.filter) == Json::String::npos)
+      continue;
+    Benchmark const* benchmark = suite.find(name);
+    if (!benchmark) {
+      std::cout << "FAIL " << name << ": no such benchmark" << std::endl;
+      ++failures;
+      continue;
+    }
+    Counters const measured = countRun(*benchmark, instructionCounter);
+    compare(name, "allocations", static_cast<double>(measured.allocations),
+            (*it)["allocations"].asDouble(), allocationTolerance);
+    if (instructions && it->isMember("instructions"))
+      compare(name, "instructions", static_cast<double>(measured.instructions),
+              (*it)["instructions"].asDouble(), instructionTolerance);
+  }
+  return failures ? 1 : 0;
+}
+
+/// Measures the checked benchmarks and writes the platform's baseline file.
+int updateBaseline(Options const& options) {
+  Suite const suite(options.seed, options.scale);
+  JsonBench::InstructionCounter instructionCounter;
+  bool const instructions = countsInstructions(instructionCounter);
+
+  Json::Value baseline;
+  baseline["platform"] = JsonBench::platformName();
+  baseline["jsoncpp_version"] = JSONCPP_VERSION_STRING;
+  baseline["seed"] = Json::UInt64(options.seed);
+  baseline["scale"] = options.scale;
+  baseline["tolerance"]["allocations"] = defaultAllocationTolerance;
+  baseline["tolerance"]["instructions"] = defaultInstructionTolerance;
+  Json::Value& benchmarks = baseline["benchmarks"];
+  benchmarks = Json::objectValue;
+  for (auto const& benchmark : suite.benchmarks) {
+    if (!isCheckedOperation(benchmark.operation) ||
+        benchmark.name().find(options.filter) == Json::String::npos)
+      continue;
+    Counters const measured = countRun(benchmark, instructionCounter);
+    Json::Value& entry = benchmarks[benchmark.name()];
+    entry["allocations"] = Json::UInt64(measured.allocations);
+    if (instructions)
+      entry["instructions"] = Json::UInt64(measured.instructions);
+  }
+
+  Json::String const path = baselinePath(options.updateDirectory);
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "  ";
+  builder["precision"] = 6;
+  std::ofstream out(path.c_str());
+  out << Json::writeString(builder, baseline) << std::endl;
+  if (!out)
+    fail("cannot write " + path);
+  std::cout << "Wrote " << path << std::endl;
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char const* argv[]) {
+  Options options;
+  int const exitCode = parseCommandLine(argc, argv, options);
+  if (exitCode >= 0)
+    return exitCode;
+  if (!options.checkDirectory.empty())
+    return checkBaseline(options);
+  if (!options.updateDirectory.empty())
+    return updateBaseline(options);
+
+  Suite const suite(options.seed, options.scale);
+  std::vector<JsonBench::Document> const& corpus = suite.corpus;
+  std::vector<Benchmark> const& benchmarks = suite.benchmarks;
+
+  if (options.list) {
+    for (auto const& benchmark : benchmarks)
+      std::cout << benchmark.name() << "\n";
+    return 0;
+  }
+
+  Json::Value report;
+  report["jsoncpp_version"] = JSONCPP_VERSION_STRING;
+  report["seed"] = Json::UInt64(options.seed);
+  report["scale"] = options.scale;
+  report["iterations"] = options.iterations;
+  for (auto const& document : corpus) {
+    char checksum[17];
+    snprintf(checksum, sizeof(checksum), "%016llx",
+             static_cast<unsigned long long>(document.checksum));
+    Json::Value& entry = report["corpus"][document.name];
+    entry["bytes"] = Json::UInt64(document.text.size());
+    entry["checksum"] = checksum;
+  }
+  report["benchmarks"] = Json::arrayValue;
+  for (auto const& benchmark : benchmarks) {
+    if (benchmark.name().find(options.filter) == Json::String::npos)
+      continue;
+    report["benchmarks"].append(measure(benchmark, options.iterations));
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "  ";
+  if (options.outputPath.empty()) {
+    std::cout << Json::writeString(builder, report) << std::endl;
+  } else {
+    std::ofstream out(options.outputPath.c_str());
+    out << Json::writeString(builder, report) << std::endl;
+    if (!out)
+      fail("cannot write " + options.outputPath);
+  }
+  return 0;
+}
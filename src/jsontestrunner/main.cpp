@@ -13,19 +13,28 @@
 /* This executable is used for testing parser/writer using real JSON files.
  */
 
+#include "../jsoncpp_bench/counters.h"
 #include <algorithm> // sort
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <json/json.h>
 #include <memory>
 #include <sstream>
 
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
 struct Options {
   Json::String path;
   Json::Features features;
   bool parseOnly;
   using writeFuncType = Json::String (*)(Json::Value const&);
   writeFuncType write;
+  /// Number of timed repetitions for --bench, or 0 to run the test.
+  unsigned int benchIterations;
 };
 
 static Json::String normalizeFloatingPointStr(double value) {
@@ -208,6 +217,134 @@ static int rewriteValueTree(const Json::String& rewritePath,
   return 0;
 }
 
+/// Peak resident set size of the process in kilobytes, or 0 if unknown.
+static long peakResidentKilobytes() {
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static size_t countNodes(Json::Value const& value) {
+  size_t nodes = 1;
+  if (value.isArray() || value.isObject()) {
+    for (auto const& child : value)
+      nodes += countNodes(child);
+  }
+  return nodes;
+}
+
+/// The reader under measurement, created once so that its setup is not
+/// part of the timings.
+class BenchReader {
+public:
+  BenchReader(const Json::Features& features, bool use_legacy)
+      : legacy_(features), useLegacy_(use_legacy) {
+    Json::CharReaderBuilder builder;
+    builder.settings_["allowComments"] = features.allowComments_;
+    builder.settings_["strictRoot"] = features.strictRoot_;
+    builder.settings_["allowDroppedNullPlaceholders"] =
+        features.allowDroppedNullPlaceholders_;
+    builder.settings_["allowNumericKeys"] = features.allowNumericKeys_;
+    modern_.reset(builder.newCharReader());
+  }
+
+  bool parse(const Json::String& input, Json::Value* root) {
+    if (useLegacy_)
+      return legacy_.parse(input.data(), input.data() + input.size(), *root);
+    return modern_->parse(input.data(), input.data() + input.size(), root,
+                          nullptr);
+  }
+
+private:
+  std::unique_ptr<Json::CharReader> modern_;
+  Json::Reader legacy_;
+  bool useLegacy_;
+};
+
+/// Parses and rewrites the input the given number of times with every
+/// reader and writer, printing one line of measurements per combination.
+/// Allocation counts are per iteration; peak RSS is that of the whole
+/// process so far, so it only grows from one line to the next.
+static int runBench(Options const& opts) {
+  Json::String const input = readInputTestFile(opts.path.c_str());
+  if (input.empty()) {
+    std::cerr << "Invalid input file: " << opts.path << std::endl;
+    return 3;
+  }
+  static struct {
+    char const* name;
+    Options::writeFuncType write;
+  } const writers[] = {
+      {"StyledWriter", &useStyledWriter},
+      {"StyledStreamWriter", &useStyledStreamWriter},
+      {"BuiltStyledStreamWriter", &useBuiltStyledStreamWriter}};
+  using Clock = std::chrono::steady_clock;
+  auto const seconds = [](Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+  };
+  double const iterations = opts.benchIterations;
+
+  printf("%-8s %-24s %11s %11s %11s %13s %13s %12s\n", "reader", "writer",
+         "parse MB/s", "write MB/s", "parse ns/n", "parse allocs",
+         "write allocs", "peak RSS KB");
+  for (bool use_legacy : {false, true}) {
+    for (auto const& writer : writers) {
+      BenchReader reader(opts.features, use_legacy);
+      Json::Value root;
+      if (!reader.parse(input, &root)) {
+        std::cerr << "Failed to parse input file: " << opts.path << std::endl;
+        return 1;
+      }
+      size_t const nodes = countNodes(root);
+      size_t outputSize = writer.write(root).size();
+
+      Clock::duration parseTime{};
+      size_t parseAllocations = 0;
+      for (unsigned int i = 0; i < opts.benchIterations; ++i) {
+        Json::Value value;
+        size_t const allocationsBefore = JsonBench::allocationCount();
+        auto const start = Clock::now();
+        reader.parse(input, &value);
+        parseTime += Clock::now() - start;
+        parseAllocations += JsonBench::allocationCount() - allocationsBefore;
+      }
+
+      Clock::duration writeTime{};
+      size_t writeAllocations = 0;
+      for (unsigned int i = 0; i < opts.benchIterations; ++i) {
+        size_t const allocationsBefore = JsonBench::allocationCount();
+        auto const start = Clock::now();
+        Json::String const output = writer.write(root);
+        writeTime += Clock::now() - start;
+        writeAllocations += JsonBench::allocationCount() - allocationsBefore;
+        outputSize = output.size();
+      }
+
+      printf("%-8s %-24s %11.2f %11.2f %11.1f %13.0f %13.0f %12ld\n",
+             use_legacy ? "legacy" : "modern", writer.name,
+             static_cast<double>(input.size()) * iterations / 1e6 /
+                 seconds(parseTime),
+             static_cast<double>(outputSize) * iterations / 1e6 /
+                 seconds(writeTime),
+             seconds(parseTime) * 1e9 / iterations /
+                 static_cast<double>(nodes),
+             static_cast<double>(parseAllocations) / iterations,
+             static_cast<double>(writeAllocations) / iterations,
+             peakResidentKilobytes());
+    }
+  }
+  return 0;
+}
+
 static Json::String removeSuffix(const Json::String& path,
                                  const Json::String& extension) {
   if (extension.length() >= path.length())
@@ -228,18 +365,30 @@ static void printConfig() {
 }
 
 static int printUsage(const char* argv[]) {
-  std::cout << "Usage: " << argv[0] << " [--strict] input-json-file"
-            << std::endl;
+  std::cout << "Usage: " << argv[0]
+            << " [--bench N] [--strict] input-json-file" << std::endl;
   return 3;
 }
 
 static int parseCommandLine(int argc, const char* argv[], Options* opts) {
   opts->parseOnly = false;
   opts->write = &useStyledWriter;
+  opts->benchIterations = 0;
   if (argc < 2) {
     return printUsage(argv);
   }
   int index = 1;
+  if (Json::String(argv[index]) == "--bench") {
+    if (index + 2 >= argc)
+      return printUsage(argv);
+    int const iterations = atoi(argv[index + 1]);
+    if (iterations <= 0) {
+      std::cerr << "Invalid '--bench' count " << argv[index + 1] << std::endl;
+      return 4;
+    }
+    opts->benchIterations = static_cast<unsigned int>(iterations);
+    index += 2;
+  }
   if (Json::String(argv[index]) == "--parse-only") {
     opts->parseOnly = true;
     ++index;
@@ -323,6 +472,14 @@ int main(int argc, const char* argv[]) {
       return exitCode;
     }
 
+    // The allocator hooks shared with jsoncpp_bench count malloc() as well
+    // as operator new, since string payloads come from malloc(); only the
+    // --bench report reads them.
+    JsonBench::countAllocations(opts.benchIterations != 0);
+    if (opts.benchIterations != 0) {
+      return runBench(opts);
+    }
+
     const int modern_return_code = runTest(opts, false);
     if (modern_return_code) {
       return modern_return_code;
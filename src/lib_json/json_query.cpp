@@ -0,0 +1,1412 @@
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/assertions.h>
+#include <json/query.h>
+#include <json/value.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace Json {
+
+namespace {
+
+/// The compiled form of a query: its segments, and the expressions and
+/// literals of its filters.
+struct QueryPlan {
+  enum SelectorKind {
+    selectName,
+    selectWildcard,
+    selectIndex,
+    selectSlice,
+    selectFilter
+  };
+  struct Selector {
+    SelectorKind kind{selectWildcard};
+    String name;
+    /// The index, or the start of a slice.
+    LargestInt index{0};
+    LargestInt end{0};
+    LargestInt step{1};
+    bool hasStart{false};
+    bool hasEnd{false};
+    /// The expression of a filter.
+    size_t filter{0};
+  };
+  struct Segment {
+    bool descendant{false};
+    std::vector<Selector> selectors;
+  };
+  /// The query itself, or one used inside a filter.
+  struct Path {
+    /// True for a query starting at '@' rather than '$'.
+    bool relative{false};
+    std::vector<Segment> segments;
+
+    /// Tells whether the path selects at most one node, as the operands of
+    /// comparisons must.
+    bool singular() const {
+      for (auto const& segment : segments) {
+        if (segment.descendant || segment.selectors.size() != 1)
+          return false;
+        SelectorKind const kind = segment.selectors.front().kind;
+        if (kind != selectName && kind != selectIndex)
+          return false;
+      }
+      return true;
+    }
+  };
+
+  enum ExprKind {
+    exprOr,
+    exprAnd,
+    exprNot,
+    exprExists,
+    exprCompare,
+    exprLiteral,
+    exprQuery,
+    exprLength,
+    exprCount,
+    exprValue
+  };
+  enum CompareOp {
+    opEqual,
+    opNotEqual,
+    opLess,
+    opLessEqual,
+    opGreater,
+    opGreaterEqual
+  };
+  /// A node of a filter expression. The operands are the indices of other
+  /// expressions, except for literals, which refer to literals, and for
+  /// queries, tests, count() and value(), which refer to paths.
+  struct Expr {
+    ExprKind kind;
+    size_t left;
+    size_t right;
+    CompareOp op;
+  };
+
+  /// paths[0] is the query itself.
+  std::vector<Path> paths;
+  std::vector<Expr> exprs;
+  std::vector<Value> literals;
+  bool streamable{false};
+};
+
+size_t const noMatch = static_cast<size_t>(-1);
+/// Largest magnitude of an index, as allowed by RFC 9535.
+LargestInt const maxQueryInt = (LargestInt(1) << 53) - 1;
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool isNameFirst(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+         static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool isNameChar(char c) { return isNameFirst(c) || (c >= '0' && c <= '9'); }
+
+void appendUtf8(String& out, unsigned int cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+bool readHex4(char const*& cur, char const* end, unsigned int& value) {
+  if (end - cur < 4)
+    return false;
+  value = 0;
+  for (int i = 0; i < 4; ++i, ++cur) {
+    char const c = *cur;
+    value <<= 4;
+    if (c >= '0' && c <= '9')
+      value += static_cast<unsigned int>(c - '0');
+    else if (c >= 'a' && c <= 'f')
+      value += static_cast<unsigned int>(c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F')
+      value += static_cast<unsigned int>(c - 'A' + 10);
+    else
+      return false;
+  }
+  return true;
+}
+
+/*!
+Decodes a string whose opening quote was consumed, up to and including the closing quote, into out.
+Accepts the JSON escapes and joins surrogate pairs; as in RFC 9535, an escaped quote must match the quotes around the string, so \' is only accepted in single-quoted strings and \" only in double-quoted ones.
+*/
+bool decodeQuoted(char const*& cur, char const* end, char quote,
+                  String& out) {
+  out.clear();
+  while (cur != end) {
+    char const c = *cur++;
+    if (c == quote)
+      return true;
+    if (static_cast<unsigned char>(c) < 0x20)
+      return false;
+    if (c != '\\') {
+      out += c;
+      continue;
+    }
+    if (cur == end)
+      return false;
+    char const escape = *cur++;
+    switch (escape) {
+    case 'b':
+      out += '\b';
+      break;
+    case 'f':
+      out += '\f';
+      break;
+    case 'n':
+      out += '\n';
+      break;
+    case 'r':
+      out += '\r';
+      break;
+    case 't':
+      out += '\t';
+      break;
+    case '/':
+    case '\\':
+      out += escape;
+      break;
+    case '"':
+    case '\'':
+      if (escape != quote)
+        return false;
+      out += escape;
+      break;
+    case 'u': {
+      unsigned int cp;
+      if (!readHex4(cur, end, cp))
+        return false;
+      if (cp >= 0xD800 && cp <= 0xDBFF) {
+        unsigned int low;
+        if (end - cur < 2 || cur[0] != '\\' || cur[1] != 'u')
+          return false;
+        cur += 2;
+        if (!readHex4(cur, end, low) || low < 0xDC00 || low > 0xDFFF)
+          return false;
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+      } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return false;
+      }
+      appendUtf8(out, cp);
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return false;
+}
+
+/// Parses JSONPath query text into a QueryPlan.
+class QueryCompiler {
+public:
+  QueryCompiler(StringView text, QueryPlan& plan)
+      : begin_(text.begin()), end_(text.end()), cur_(text.begin()),
+        plan_(plan) {}
+
+  bool compile(String* error) {
+    plan_.paths.emplace_back();
+    if (!parseQueryText()) {
+      if (error)
+        *error = error_;
+      return false;
+    }
+    plan_.streamable = streamable(plan_.paths.front());
+    return true;
+  }
+
+private:
+  bool fail(char const* message) {
+    if (error_.empty()) {
+      OStringStream out;
+      out << message << " at offset " << (cur_ - begin_);
+      error_ = out.str();
+    }
+    return false;
+  }
+
+  bool parseQueryText() {
+    if (cur_ == end_ || *cur_ != '$')
+      return fail("Expected '$'");
+    ++cur_;
+    if (!parseSegments(0))
+      return false;
+    if (cur_ != end_)
+      return fail("Unexpected character");
+    return true;
+  }
+
+  bool at(char c) const { return cur_ != end_ && *cur_ == c; }
+  bool at(char const* token) const {
+    size_t const length = strlen(token);
+    return size_t(end_ - cur_) >= length && memcmp(cur_, token, length) == 0;
+  }
+  void skipBlank() {
+    while (cur_ != end_ && isBlank(*cur_))
+      ++cur_;
+  }
+
+  /*!
+  Parses the segments following '$' or '@' into the given path; blank space is only consumed when a segment follows it.
+  */
+  bool parseSegments(size_t path) {
+    for (;;) {
+      char const* const save = cur_;
+      skipBlank();
+      QueryPlan::Segment segment;
+      if (at("..")) {
+        cur_ += 2;
+        segment.descendant = true;
+        if (at('[')) {
+          if (!parseBracket(segment))
+            return false;
+        } else if (!parseShorthand(segment)) {
+          return fail("Expected a name, '*' or '[' after '..'");
+        }
+      } else if (at('.')) {
+        ++cur_;
+        if (!parseShorthand(segment))
+          return fail("Expected a name or '*' after '.'");
+      } else if (at('[')) {
+        if (!parseBracket(segment))
+          return false;
+      } else {
+        cur_ = save;
+        return true;
+      }
+      plan_.paths[path].segments.push_back(std::move(segment));
+    }
+  }
+
+  bool parseShorthand(QueryPlan::Segment& segment) {
+    QueryPlan::Selector selector;
+    if (at('*')) {
+      ++cur_;
+    } else if (cur_ != end_ && isNameFirst(*cur_)) {
+      char const* const start = cur_;
+      while (cur_ != end_ && isNameChar(*cur_))
+        ++cur_;
+      selector.kind = QueryPlan::selectName;
+      selector.name.assign(start, cur_);
+    } else {
+      return false;
+    }
+    segment.selectors.push_back(std::move(selector));
+    return true;
+  }
+
+  bool parseBracket(QueryPlan::Segment& segment) {
+    ++cur_;
+    for (;;) {
+      skipBlank();
+      QueryPlan::Selector selector;
+      if (!parseSelector(selector))
+        return false;
+      segment.selectors.push_back(std::move(selector));
+      skipBlank();
+      if (at(',')) {
+        ++cur_;
+      } else if (at(']')) {
+        ++cur_;
+        return true;
+      } else {
+        return fail("Expected ',' or ']'");
+      }
+    }
+  }
+
+  bool parseSelector(QueryPlan::Selector& selector) {
+    if (at('\'') || at('"')) {
+      selector.kind = QueryPlan::selectName;
+      return parseString(selector.name);
+    }
+    if (at('*')) {
+      ++cur_;
+      selector.kind = QueryPlan::selectWildcard;
+      return true;
+    }
+    if (at('?')) {
+      ++cur_;
+      skipBlank();
+      selector.kind = QueryPlan::selectFilter;
+      return parseOr(selector.filter);
+    }
+    if (!at('-') && !at(':') && !(cur_ != end_ && *cur_ >= '0' && *cur_ <= '9'))
+      return fail("Expected a selector");
+    selector.hasStart = !at(':');
+    if (selector.hasStart && !parseInt(selector.index))
+      return false;
+    skipBlank();
+    if (!at(':')) {
+      if (!selector.hasStart)
+        return fail("Expected an index");
+      selector.kind = QueryPlan::selectIndex;
+      return true;
+    }
+    ++cur_;
+    selector.kind = QueryPlan::selectSlice;
+    skipBlank();
+    if (at('-') || (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9')) {
+      selector.hasEnd = true;
+      if (!parseInt(selector.end))
+        return false;
+      skipBlank();
+    }
+    if (at(':')) {
+      ++cur_;
+      skipBlank();
+      if (at('-') || (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9'))
+        return parseInt(selector.step);
+    }
+    return true;
+  }
+
+  bool parseInt(LargestInt& value) {
+    bool const negative = at('-');
+    if (negative)
+      ++cur_;
+    if (cur_ == end_ || *cur_ < '0' || *cur_ > '9')
+      return fail("Expected a digit");
+    if (*cur_ == '0' && (negative || (cur_ + 1 != end_ && cur_[1] >= '0' &&
+                                      cur_[1] <= '9')))
+      return fail("Leading zeros are not allowed");
+    value = 0;
+    while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9') {
+      value = value * 10 + (*cur_++ - '0');
+      if (value > maxQueryInt)
+        return fail("Integer out of range");
+    }
+    if (negative)
+      value = -value;
+    return true;
+  }
+
+  bool parseString(String& out) {
+    char const quote = *cur_++;
+    if (!decodeQuoted(cur_, end_, quote, out))
+      return fail("Invalid string literal");
+    return true;
+  }
+
+  size_t addExpr(QueryPlan::ExprKind kind, size_t left, size_t right = 0,
+                 QueryPlan::CompareOp op = QueryPlan::opEqual) {
+    plan_.exprs.push_back(QueryPlan::Expr{kind, left, right, op});
+    return plan_.exprs.size() - 1;
+  }
+
+  bool parseOr(size_t& expr) {
+    if (!parseAnd(expr))
+      return false;
+    for (;;) {
+      skipBlank();
+      if (!at("||"))
+        return true;
+      cur_ += 2;
+      size_t right;
+      if (!parseAnd(right))
+        return false;
+      expr = addExpr(QueryPlan::exprOr, expr, right);
+    }
+  }
+
+  bool parseAnd(size_t& expr) {
+    if (!parseBasic(expr))
+      return false;
+    for (;;) {
+      skipBlank();
+      if (!at("&&"))
+        return true;
+      cur_ += 2;
+      size_t right;
+      if (!parseBasic(right))
+        return false;
+      expr = addExpr(QueryPlan::exprAnd, expr, right);
+    }
+  }
+
+  bool parseParenthesized(size_t& expr) {
+    ++cur_;
+    skipBlank();
+    if (!parseOr(expr))
+      return false;
+    skipBlank();
+    if (!at(')'))
+      return fail("Expected ')'");
+    ++cur_;
+    return true;
+  }
+
+  /*!
+  Parses a parenthesized expression, a negation, a comparison or a test, which is a query standing alone.
+  */
+  bool parseBasic(size_t& expr) {
+    skipBlank();
+    if (at('!')) {
+      ++cur_;
+      skipBlank();
+      size_t operand;
+      if (at('(')) {
+        if (!parseParenthesized(operand))
+          return false;
+      } else if (!parseTest(operand)) {
+        return false;
+      }
+      expr = addExpr(QueryPlan::exprNot, operand);
+      return true;
+    }
+    if (at('('))
+      return parseParenthesized(expr);
+
+    char const* const start = cur_;
+    size_t left;
+    if (!parseComparable(left))
+      return false;
+    skipBlank();
+    QueryPlan::CompareOp op;
+    if (!parseCompareOp(op)) {
+      cur_ = start;
+      return parseTest(expr);
+    }
+    size_t right;
+    skipBlank();
+    if (!checkComparable(left) || !parseComparable(right) ||
+        !checkComparable(right))
+      return false;
+    expr = addExpr(QueryPlan::exprCompare, left, right, op);
+    return true;
+  }
+
+  bool parseTest(size_t& expr) {
+    if (!at('@') && !at('$'))
+      return fail("Expected a query to test");
+    size_t query;
+    if (!parseComparable(query))
+      return false;
+    expr = addExpr(QueryPlan::exprExists, plan_.exprs[query].left);
+    return true;
+  }
+
+  bool parseCompareOp(QueryPlan::CompareOp& op) {
+    struct Token {
+      char const* text;
+      QueryPlan::CompareOp op;
+    };
+    static Token const tokens[] = {
+        {"==", QueryPlan::opEqual},       {"!=", QueryPlan::opNotEqual},
+        {"<=", QueryPlan::opLessEqual},   {">=", QueryPlan::opGreaterEqual},
+        {"<", QueryPlan::opLess},         {">", QueryPlan::opGreater}};
+    for (auto const& token : tokens) {
+      if (at(token.text)) {
+        cur_ += strlen(token.text);
+        op = token.op;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Queries compared with something must select at most one node.
+  bool checkComparable(size_t expr) {
+    QueryPlan::Expr const& e = plan_.exprs[expr];
+    if (e.kind == QueryPlan::exprQuery && !plan_.paths[e.left].singular())
+      return fail("Only singular queries can be compared");
+    if (e.kind == QueryPlan::exprCount || e.kind == QueryPlan::exprLength ||
+        e.kind == QueryPlan::exprValue || e.kind == QueryPlan::exprLiteral ||
+        e.kind == QueryPlan::exprQuery)
+      return true;
+    return fail("Expected a comparable value");
+  }
+
+  bool parseQuery(size_t& expr) {
+    bool const relative = *cur_ == '@';
+    ++cur_;
+    size_t const path = plan_.paths.size();
+    plan_.paths.emplace_back();
+    plan_.paths.back().relative = relative;
+    if (!parseSegments(path))
+      return false;
+    expr = addExpr(QueryPlan::exprQuery, path);
+    return true;
+  }
+
+  size_t addLiteral(Value value) {
+    plan_.literals.push_back(std::move(value));
+    return addExpr(QueryPlan::exprLiteral, plan_.literals.size() - 1);
+  }
+
+  bool parseNumber(size_t& expr) {
+    char const* const start = cur_;
+    if (at('-'))
+      ++cur_;
+    char const* const digits = cur_;
+    while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9')
+      ++cur_;
+    if (cur_ == digits)
+      return fail("Expected a digit");
+    if (*digits == '0' && cur_ - digits > 1) {
+      cur_ = digits;
+      return fail("Leading zeros are not allowed");
+    }
+    bool integral = true;
+    if (at('.')) {
+      integral = false;
+      ++cur_;
+      char const* const fraction = cur_;
+      while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9')
+        ++cur_;
+      if (cur_ == fraction)
+        return fail("Expected a digit");
+    }
+    if (at('e') || at('E')) {
+      integral = false;
+      ++cur_;
+      if (at('+') || at('-'))
+        ++cur_;
+      char const* const exponent = cur_;
+      while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9')
+        ++cur_;
+      if (cur_ == exponent)
+        return fail("Expected a digit");
+    }
+    String const text(start, cur_);
+    if (integral && cur_ - digits <= 18) {
+      expr = addLiteral(Value(LargestInt(strtoll(text.c_str(), nullptr, 10))));
+    } else {
+      expr = addLiteral(Value(strtod(text.c_str(), nullptr)));
+    }
+    return true;
+  }
+
+  bool parseKeyword(char const* word) {
+    if (!at(word))
+      return false;
+    char const* const after = cur_ + strlen(word);
+    if (after != end_ && isNameChar(*after))
+      return false;
+    cur_ = after;
+    return true;
+  }
+
+  bool parseFunction(size_t& expr) {
+    char const* const start = cur_;
+    while (cur_ != end_ && ((*cur_ >= 'a' && *cur_ <= 'z') || *cur_ == '_' ||
+                            (*cur_ >= '0' && *cur_ <= '9')))
+      ++cur_;
+    String const name(start, cur_);
+    if (!at('(')) {
+      cur_ = start;
+      return fail("Expected a query, a literal or a function");
+    }
+    ++cur_;
+    skipBlank();
+    size_t argument;
+    QueryPlan::ExprKind kind;
+    if (name == "length") {
+      kind = QueryPlan::exprLength;
+      if (!parseComparable(argument) || !checkComparable(argument))
+        return false;
+    } else if (name == "count" || name == "value") {
+      kind = name == "count" ? QueryPlan::exprCount : QueryPlan::exprValue;
+      if (!at('@') && !at('$'))
+        return fail("Expected a query");
+      if (!parseQuery(argument))
+        return false;
+      argument = plan_.exprs[argument].left;
+    } else {
+      cur_ = start;
+      return fail("Unknown function");
+    }
+    skipBlank();
+    if (!at(')'))
+      return fail("Expected ')'");
+    ++cur_;
+    expr = addExpr(kind, argument);
+    return true;
+  }
+
+  bool parseComparable(size_t& expr) {
+    if (at('@') || at('$'))
+      return parseQuery(expr);
+    if (at('\'') || at('"')) {
+      String text;
+      if (!parseString(text))
+        return false;
+      expr = addLiteral(Value(text));
+      return true;
+    }
+    if (at('-') || (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9'))
+      return parseNumber(expr);
+    if (parseKeyword("true")) {
+      expr = addLiteral(Value(true));
+      return true;
+    }
+    if (parseKeyword("false")) {
+      expr = addLiteral(Value(false));
+      return true;
+    }
+    if (parseKeyword("null")) {
+      expr = addLiteral(Value());
+      return true;
+    }
+    return parseFunction(expr);
+  }
+
+  /// Whether a value can be matched from the names and indices leading to
+  /// it, without looking at any other part of the document.
+  static bool streamable(QueryPlan::Path const& path) {
+    if (path.segments.size() >= 64)
+      return false;
+    for (auto const& segment : path.segments) {
+      for (auto const& selector : segment.selectors) {
+        switch (selector.kind) {
+        case QueryPlan::selectName:
+        case QueryPlan::selectWildcard:
+          break;
+        case QueryPlan::selectIndex:
+          if (selector.index < 0)
+            return false;
+          break;
+        case QueryPlan::selectSlice:
+          if (selector.step < 0 || (selector.hasStart && selector.index < 0) ||
+              (selector.hasEnd && selector.end < 0))
+            return false;
+          break;
+        case QueryPlan::selectFilter:
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  char const* begin_;
+  char const* end_;
+  char const* cur_;
+  QueryPlan& plan_;
+  String error_;
+};
+
+/// Evaluates the paths and filters of a plan against one document.
+class QueryEvaluator {
+public:
+  QueryEvaluator(QueryPlan const& plan, Value const& root)
+      : plan_(plan), root_(root) {}
+
+  /*!
+  Calls visit with every node the path selects, in order, until visit returns false.
+  Keeps the nodes still to visit on an explicit stack: each step pushes the nodes its segment selects, then, for descendant segments, the children to apply the same segment to, both reversed so that they come off the stack in document order.
+  */
+  template <typename Visit>
+  bool run(QueryPlan::Path const& path, Value const& current, Visit visit) {
+    struct Frame {
+      size_t segment;
+      Value const* node;
+    };
+    std::vector<Frame> stack{{0, path.relative ? &current : &root_}};
+    std::vector<Value const*> selected;
+    while (!stack.empty()) {
+      Frame const frame = stack.back();
+      stack.pop_back();
+      if (frame.segment == path.segments.size()) {
+        if (!visit(*frame.node))
+          return false;
+        continue;
+      }
+      QueryPlan::Segment const& segment = path.segments[frame.segment];
+      selected.clear();
+      for (auto const& selector : segment.selectors)
+        select(selector, *frame.node, selected);
+      size_t const mark = stack.size();
+      for (Value const* node : selected)
+        stack.push_back(Frame{frame.segment + 1, node});
+      if (segment.descendant)
+        for (auto const& child : *frame.node)
+          stack.push_back(Frame{frame.segment, &child});
+      std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(mark),
+                   stack.end());
+    }
+    return true;
+  }
+
+private:
+  /// The result of an operand of a comparison: nothing, a value in the
+  /// document or the plan, or a number computed by a function.
+  struct Operand {
+    enum Kind { nothing, value, number } kind{nothing};
+    Value const* node{nullptr};
+    LargestInt count{0};
+  };
+
+  Value const* singular(QueryPlan::Path const& path, Value const& current) {
+    Value const* node = path.relative ? &current : &root_;
+    for (auto const& segment : path.segments) {
+      QueryPlan::Selector const& selector = segment.selectors.front();
+      if (selector.kind == QueryPlan::selectName) {
+        node = node->isObject() ? node->find(selector.name.data(),
+                                             selector.name.data() +
+                                                 selector.name.size())
+                                : nullptr;
+      } else {
+        node = arrayElement(*node, selector.index);
+      }
+      if (!node)
+        return nullptr;
+    }
+    return node;
+  }
+
+  static Value const* arrayElement(Value const& node, LargestInt index) {
+    if (!node.isArray())
+      return nullptr;
+    auto const size = static_cast<LargestInt>(node.size());
+    if (index < 0)
+      index += size;
+    if (index < 0 || index >= size)
+      return nullptr;
+    return node.findIndex(static_cast<ArrayIndex>(index));
+  }
+
+  void select(QueryPlan::Selector const& selector, Value const& node,
+              std::vector<Value const*>& out) {
+    switch (selector.kind) {
+    case QueryPlan::selectName:
+      if (node.isObject()) {
+        if (Value const* found =
+                node.find(selector.name.data(),
+                          selector.name.data() + selector.name.size()))
+          out.push_back(found);
+      }
+      break;
+    case QueryPlan::selectWildcard:
+      for (auto const& child : node)
+        out.push_back(&child);
+      break;
+    case QueryPlan::selectIndex:
+      if (Value const* found = arrayElement(node, selector.index))
+        out.push_back(found);
+      break;
+    case QueryPlan::selectSlice:
+      selectSlice(selector, node, out);
+      break;
+    case QueryPlan::selectFilter:
+      for (auto const& child : node)
+        if (test(selector.filter, child))
+          out.push_back(&child);
+      break;
+    }
+  }
+
+  /// Adds the element at a normalized index; indices of a sparse array that
+  /// were never assigned hold no element and are skipped.
+  static void addElement(Value const& node, LargestInt index,
+                         std::vector<Value const*>& out) {
+    if (Value const* element = node.findIndex(static_cast<ArrayIndex>(index)))
+      out.push_back(element);
+  }
+
+  /*!
+  Normalizes the bounds of the slice as RFC 9535 section 2.3.4.2.2 describes, then steps through them.
+  */
+  static void selectSlice(QueryPlan::Selector const& selector,
+                          Value const& node, std::vector<Value const*>& out) {
+    if (!node.isArray() || selector.step == 0)
+      return;
+    auto const length = static_cast<LargestInt>(node.size());
+    auto const normalize = [length](LargestInt i) {
+      return i >= 0 ? i : length + i;
+    };
+    LargestInt const step = selector.step;
+    if (step > 0) {
+      LargestInt const start = selector.hasStart ? normalize(selector.index) : 0;
+      LargestInt const end = selector.hasEnd ? normalize(selector.end) : length;
+      LargestInt const lower = std::min(std::max(start, LargestInt(0)), length);
+      LargestInt const upper = std::min(std::max(end, LargestInt(0)), length);
+      for (LargestInt i = lower; i < upper; i += step)
+        addElement(node, i, out);
+    } else {
+      LargestInt const start =
+          selector.hasStart ? normalize(selector.index) : length - 1;
+      LargestInt const end =
+          selector.hasEnd ? normalize(selector.end) : -length - 1;
+      LargestInt const upper =
+          std::min(std::max(start, LargestInt(-1)), length - 1);
+      LargestInt const lower = std::min(std::max(end, LargestInt(-1)), length - 1);
+      for (LargestInt i = upper; lower < i; i += step)
+        addElement(node, i, out);
+    }
+  }
+
+  bool test(size_t expr, Value const& current) {
+    QueryPlan::Expr const& e = plan_.exprs[expr];
+    switch (e.kind) {
+    case QueryPlan::exprOr:
+      return test(e.left, current) || test(e.right, current);
+    case QueryPlan::exprAnd:
+      return test(e.left, current) && test(e.right, current);
+    case QueryPlan::exprNot:
+      return !test(e.left, current);
+    case QueryPlan::exprExists: {
+      QueryPlan::Path const& path = plan_.paths[e.left];
+      if (path.singular())
+        return singular(path, current) != nullptr;
+      return !run(path, current, [](Value const&) { return false; });
+    }
+    case QueryPlan::exprCompare:
+      return compare(operand(e.left, current), operand(e.right, current),
+                     e.op);
+    default:
+      JSON_ASSERT_MESSAGE(false, "Unexpected filter expression");
+    }
+    return false;
+  }
+
+  Operand operand(size_t expr, Value const& current) {
+    QueryPlan::Expr const& e = plan_.exprs[expr];
+    Operand result;
+    switch (e.kind) {
+    case QueryPlan::exprLiteral:
+      result.kind = Operand::value;
+      result.node = &plan_.literals[e.left];
+      break;
+    case QueryPlan::exprQuery:
+      result.node = singular(plan_.paths[e.left], current);
+      result.kind = result.node ? Operand::value : Operand::nothing;
+      break;
+    case QueryPlan::exprValue: {
+      size_t found = 0;
+      run(plan_.paths[e.left], current, [&](Value const& node) {
+        result.node = &node;
+        return ++found < 2;
+      });
+      result.kind = found == 1 ? Operand::value : Operand::nothing;
+      break;
+    }
+    case QueryPlan::exprCount:
+      result.kind = Operand::number;
+      run(plan_.paths[e.left], current, [&result](Value const&) {
+        ++result.count;
+        return true;
+      });
+      break;
+    case QueryPlan::exprLength: {
+      Operand const argument = operand(e.left, current);
+      if (argument.kind != Operand::value)
+        break;
+      Value const& value = *argument.node;
+      char const* begin;
+      char const* end;
+      if (value.isString() && value.getString(&begin, &end)) {
+        result.kind = Operand::number;
+        for (; begin != end; ++begin)
+          result.count += (static_cast<unsigned char>(*begin) & 0xC0) != 0x80;
+      } else if (value.isArray() || value.isObject()) {
+        result.kind = Operand::number;
+        result.count = static_cast<LargestInt>(value.size());
+      }
+      break;
+    }
+    default:
+      JSON_ASSERT_MESSAGE(false, "Unexpected filter expression");
+    }
+    return result;
+  }
+
+  static bool isNumber(Operand const& operand) {
+    return operand.kind == Operand::number ||
+           (operand.kind == Operand::value && operand.node->isNumeric());
+  }
+
+  /// Orders two numbers without losing the precision of large integers.
+  static int compareNumbers(Operand const& a, Operand const& b) {
+    auto const kind = [](Operand const& o) {
+      return o.kind == Operand::number ? intValue : o.node->type();
+    };
+    auto const asInt = [](Operand const& o) {
+      return o.kind == Operand::number ? o.count : o.node->asLargestInt();
+    };
+    ValueType const ka = kind(a);
+    ValueType const kb = kind(b);
+    if (ka == realValue || kb == realValue) {
+      double const da = a.kind == Operand::number ? double(a.count)
+                                                  : a.node->asDouble();
+      double const db = b.kind == Operand::number ? double(b.count)
+                                                  : b.node->asDouble();
+      return da < db ? -1 : (db < da ? 1 : 0);
+    }
+    if (ka == uintValue && kb == uintValue) {
+      LargestUInt const ua = a.node->asLargestUInt();
+      LargestUInt const ub = b.node->asLargestUInt();
+      return ua < ub ? -1 : (ub < ua ? 1 : 0);
+    }
+    if (ka == uintValue)
+      return -compareNumbers(b, a);
+    // a is a signed integer here.
+    LargestInt const ia = asInt(a);
+    if (kb == uintValue) {
+      if (ia < 0)
+        return -1;
+      LargestUInt const ub = b.node->asLargestUInt();
+      return LargestUInt(ia) < ub ? -1 : (ub < LargestUInt(ia) ? 1 : 0);
+    }
+    LargestInt const ib = asInt(b);
+    return ia < ib ? -1 : (ib < ia ? 1 : 0);
+  }
+
+  static Operand valueOperand(Value const& node) {
+    Operand result;
+    result.kind = Operand::value;
+    result.node = &node;
+    return result;
+  }
+
+  /*!
+  Compares arrays and objects member by member with an explicit stack, so that numbers inside them are equal by value, as 1 and 1.0 are, rather than by type as Value::operator== has it.
+  */
+  static bool sameValue(Value const& a, Value const& b) {
+    std::vector<std::pair<Value const*, Value const*>> pending{{&a, &b}};
+    while (!pending.empty()) {
+      Value const& x = *pending.back().first;
+      Value const& y = *pending.back().second;
+      pending.pop_back();
+      if (x.isNumeric() && y.isNumeric()) {
+        if (compareNumbers(valueOperand(x), valueOperand(y)) != 0)
+          return false;
+      } else if (x.type() != y.type() || x.size() != y.size()) {
+        return false;
+      } else if (x.isArray()) {
+        for (ArrayIndex i = 0; i < x.size(); ++i)
+          pending.emplace_back(&x[i], &y[i]);
+      } else if (x.isObject()) {
+        for (auto it = x.begin(); it != x.end(); ++it) {
+          StringView const key = it.keyView();
+          Value const* other = y.find(key.begin(), key.end());
+          if (!other)
+            return false;
+          pending.emplace_back(&*it, other);
+        }
+      } else if (!(x == y)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool equal(Operand const& a, Operand const& b) {
+    if (a.kind == Operand::nothing || b.kind == Operand::nothing)
+      return a.kind == b.kind;
+    bool const na = isNumber(a);
+    bool const nb = isNumber(b);
+    if (na || nb)
+      return na && nb && compareNumbers(a, b) == 0;
+    return sameValue(*a.node, *b.node);
+  }
+
+  static bool less(Operand const& a, Operand const& b) {
+    if (isNumber(a) && isNumber(b))
+      return compareNumbers(a, b) < 0;
+    if (a.kind == Operand::value && b.kind == Operand::value &&
+        a.node->isString() && b.node->isString())
+      return *a.node < *b.node;
+    return false;
+  }
+
+  static bool compare(Operand const& a, Operand const& b,
+                      QueryPlan::CompareOp op) {
+    switch (op) {
+    case QueryPlan::opEqual:
+      return equal(a, b);
+    case QueryPlan::opNotEqual:
+      return !equal(a, b);
+    case QueryPlan::opLess:
+      return less(a, b);
+    case QueryPlan::opLessEqual:
+      return less(a, b) || equal(a, b);
+    case QueryPlan::opGreater:
+      return less(b, a);
+    case QueryPlan::opGreaterEqual:
+      return less(b, a) || equal(a, b);
+    }
+    return false;
+  }
+
+  QueryPlan const& plan_;
+  Value const& root_;
+};
+
+/// Applies a streamable plan to JSON text, tracking for every open
+/// container the set of segments that its children can still match.
+class QueryStreamer {
+public:
+  QueryStreamer(QueryPlan::Path const& path, char const* begin,
+                char const* end)
+      : path_(path), cur_(begin), end_(end),
+        accept_(uint64_t(1) << path.segments.size()) {}
+
+  bool run(std::vector<StringView>& out) {
+    struct Frame {
+      char close;
+      ArrayIndex index;
+      uint64_t states;
+      size_t match;
+      char const* start;
+    };
+    std::vector<Frame> stack;
+    uint64_t states = 1;
+    for (;;) {
+      // A value, with the set of segments reached at it in states.
+      skipBlank();
+      if (cur_ == end_)
+        return false;
+      char const* const start = cur_;
+      size_t match = noMatch;
+      if (states & accept_) {
+        match = out.size();
+        out.push_back(StringView(start, 0));
+      }
+      bool closed = true;
+      if (*cur_ == '{' || *cur_ == '[') {
+        char const close = *cur_ == '{' ? '}' : ']';
+        if ((states & (accept_ - 1)) == 0) {
+          if (!skipContainer())
+            return false;
+        } else {
+          ++cur_;
+          skipBlank();
+          if (cur_ != end_ && *cur_ == close) {
+            ++cur_;
+          } else {
+            stack.push_back(Frame{close, 0, states, match, start});
+            if (close == ']') {
+              states = advanceIndex(states, 0);
+            } else if (readKey()) {
+              states = advanceKey(states);
+            } else {
+              return false;
+            }
+            closed = false;
+          }
+        }
+      } else if (!skipScalar()) {
+        return false;
+      }
+      if (!closed)
+        continue;
+      if (match != noMatch)
+        out[match] = StringView(start, size_t(cur_ - start));
+
+      // After a value: the next member or element, or the end of containers.
+      for (;;) {
+        skipBlank();
+        if (stack.empty())
+          return cur_ == end_;
+        Frame& frame = stack.back();
+        if (cur_ != end_ && *cur_ == ',') {
+          ++cur_;
+          if (frame.close == '}') {
+            if (!readKey())
+              return false;
+            states = advanceKey(frame.states);
+          } else {
+            states = advanceIndex(frame.states, ++frame.index);
+          }
+          break;
+        }
+        if (cur_ == end_ || *cur_ != frame.close)
+          return false;
+        ++cur_;
+        if (frame.match != noMatch)
+          out[frame.match] =
+              StringView(frame.start, size_t(cur_ - frame.start));
+        stack.pop_back();
+      }
+    }
+  }
+
+private:
+  void skipBlank() {
+    while (cur_ != end_ && isBlank(*cur_))
+      ++cur_;
+  }
+
+  /// Moves past a string whose opening quote cur_ points at, checking its
+  /// escapes and noting whether it has any.
+  bool skipString(bool& escaped) {
+    escaped = false;
+    for (++cur_; cur_ != end_;) {
+      char const c = *cur_++;
+      if (c == '"')
+        return true;
+      if (static_cast<unsigned char>(c) < 0x20)
+        return false;
+      if (c != '\\')
+        continue;
+      escaped = true;
+      if (cur_ == end_)
+        return false;
+      char const escape = *cur_++;
+      if (escape == 'u') {
+        unsigned int unit;
+        if (!readHex4(cur_, end_, unit))
+          return false;
+      } else if (escape == 0 || !strchr("\"\\/bfnrt", escape)) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  bool skipDigits() {
+    char const* const digits = cur_;
+    while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9')
+      ++cur_;
+    return cur_ != digits;
+  }
+
+  /// Moves past a number, following the JSON grammar.
+  bool skipNumber() {
+    if (*cur_ == '-')
+      ++cur_;
+    if (cur_ != end_ && *cur_ == '0')
+      ++cur_;
+    else if (!skipDigits())
+      return false;
+    if (cur_ != end_ && *cur_ == '.') {
+      ++cur_;
+      if (!skipDigits())
+        return false;
+    }
+    if (cur_ != end_ && (*cur_ == 'e' || *cur_ == 'E')) {
+      ++cur_;
+      if (cur_ != end_ && (*cur_ == '+' || *cur_ == '-'))
+        ++cur_;
+      if (!skipDigits())
+        return false;
+    }
+    return true;
+  }
+
+  bool skipScalar() {
+    bool escaped;
+    switch (*cur_) {
+    case '"':
+      return skipString(escaped);
+    case 't':
+      return skipWord("true");
+    case 'f':
+      return skipWord("false");
+    case 'n':
+      return skipWord("null");
+    default:
+      return skipNumber();
+    }
+  }
+
+  bool skipWord(char const* word) {
+    size_t const length = strlen(word);
+    if (size_t(end_ - cur_) < length || memcmp(cur_, word, length) != 0)
+      return false;
+    cur_ += length;
+    return true;
+  }
+
+  /// Moves past a member name and the following ':' without decoding it.
+  bool skipKey() {
+    skipBlank();
+    bool escaped;
+    if (cur_ == end_ || *cur_ != '"' || !skipString(escaped))
+      return false;
+    skipBlank();
+    if (cur_ == end_ || *cur_ != ':')
+      return false;
+    ++cur_;
+    return true;
+  }
+
+  /*!
+  Moves past a container in which nothing can match. Its syntax is checked as in run(), but without tracking states or decoding names, using a stack of the expected closing brackets.
+  */
+  bool skipContainer() {
+    closers_.clear();
+    for (;;) {
+      skipBlank();
+      if (cur_ == end_)
+        return false;
+      if (*cur_ == '{' || *cur_ == '[') {
+        char const close = *cur_ == '{' ? '}' : ']';
+        ++cur_;
+        skipBlank();
+        if (cur_ == end_ || *cur_ != close) {
+          closers_.push_back(close);
+          if (close == '}' && !skipKey())
+            return false;
+          continue;
+        }
+        ++cur_;
+      } else if (!skipScalar()) {
+        return false;
+      }
+      for (;;) {
+        if (closers_.empty())
+          return true;
+        skipBlank();
+        if (cur_ != end_ && *cur_ == ',') {
+          ++cur_;
+          if (closers_.back() == '}' && !skipKey())
+            return false;
+          break;
+        }
+        if (cur_ == end_ || *cur_ != closers_.back())
+          return false;
+        ++cur_;
+        closers_.pop_back();
+      }
+    }
+  }
+
+  /// Reads a member name and the following ':' into key_, decoding it only
+  /// if it contains escapes.
+  bool readKey() {
+    skipBlank();
+    if (cur_ == end_ || *cur_ != '"')
+      return false;
+    char const* const start = cur_;
+    bool escaped;
+    if (!skipString(escaped))
+      return false;
+    if (escaped) {
+      char const* text = start + 1;
+      if (!decodeQuoted(text, cur_, '"', decoded_))
+        return false;
+      key_ = StringView(decoded_);
+    } else {
+      key_ = StringView(start + 1, size_t(cur_ - start - 2));
+    }
+    skipBlank();
+    if (cur_ == end_ || *cur_ != ':')
+      return false;
+    ++cur_;
+    return true;
+  }
+
+  /*!
+  Moves every reached segment forward over one step: a descendant segment also stays where it is, since it may match further down.
+  */
+  template <typename Matches> uint64_t advance(uint64_t states, Matches matches) {
+    uint64_t next = 0;
+    for (size_t s = 0; s < path_.segments.size(); ++s) {
+      if (!(states & (uint64_t(1) << s)))
+        continue;
+      QueryPlan::Segment const& segment = path_.segments[s];
+      if (segment.descendant)
+        next |= uint64_t(1) << s;
+      for (auto const& selector : segment.selectors) {
+        if (matches(selector)) {
+          next |= uint64_t(1) << (s + 1);
+          break;
+        }
+      }
+    }
+    return next;
+  }
+
+  uint64_t advanceKey(uint64_t states) {
+    return advance(states, [this](QueryPlan::Selector const& selector) {
+      return selector.kind == QueryPlan::selectWildcard ||
+             (selector.kind == QueryPlan::selectName &&
+              key_ == StringView(selector.name));
+    });
+  }
+
+  uint64_t advanceIndex(uint64_t states, ArrayIndex index) {
+    auto const i = static_cast<LargestInt>(index);
+    return advance(states, [i](QueryPlan::Selector const& selector) {
+      switch (selector.kind) {
+      case QueryPlan::selectWildcard:
+        return true;
+      case QueryPlan::selectIndex:
+        return selector.index == i;
+      case QueryPlan::selectSlice: {
+        LargestInt const start = selector.hasStart ? selector.index : 0;
+        return selector.step > 0 && i >= start &&
+               (!selector.hasEnd || i < selector.end) &&
+               (i - start) % selector.step == 0;
+      }
+      default:
+        return false;
+      }
+    });
+  }
+
+  QueryPlan::Path const& path_;
+  char const* cur_;
+  char const* const end_;
+  uint64_t const accept_;
+  StringView key_;
+  String decoded_;
+  std::vector<char> closers_;
+};
+
+} // namespace
+
+class Query::Impl : public QueryPlan {};
+
+Query::Query() = default;
+
+Query::Query(std::shared_ptr<Impl const> impl) : impl_(std::move(impl)) {}
+
+bool Query::compile(StringView expression, Query* query, String* error) {
+  auto impl = std::make_shared<Impl>();
+  if (!QueryCompiler(expression, *impl).compile(error))
+    return false;
+  *query = Query(std::move(impl));
+  return true;
+}
+
+void Query::select(const Value& root, std::vector<Value const*>& out) const {
+  if (!impl_)
+    return;
+  QueryEvaluator(*impl_, root)
+      .run(impl_->paths.front(), root, [&out](Value const& node) {
+        out.push_back(&node);
+        return true;
+      });
+}
+
+std::vector<Value const*> Query::select(const Value& root) const {
+  std::vector<Value const*> out;
+  select(root, out);
+  return out;
+}
+
+bool Query::isStreamable() const { return impl_ && impl_->streamable; }
+
+bool Query::selectText(char const* begin, char const* end,
+                       std::vector<StringView>& out) const {
+  if (!isStreamable())
+    return false;
+  return QueryStreamer(impl_->paths.front(), begin, end).run(out);
+}
+
+} // namespace Json
@@ -6,6 +6,7 @@
 #endif
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <iostream>
@@ -69,6 +70,70 @@ Features Features::strictMode() {
   return features;
 }
 
+LineIndex::LineIndex() : begin_(nullptr), end_(nullptr), built_(false) {}
+
+LineIndex::LineIndex(char const* begin, char const* end)
+    : begin_(begin), end_(end), built_(false) {}
+
+void LineIndex::reset(char const* begin, char const* end) {
+  begin_ = begin;
+  end_ = end;
+  lineStarts_.clear();
+  built_ = false;
+}
+
+/*!
+Collects the offset of every line start. memchr() is vectorized by the common C libraries, so documents without '\r' are scanned a block at a time; only documents containing '\r' take the byte by byte loop that handles "\r\n" and lone '\r'.
+*/
+void LineIndex::build() const {
+  lineStarts_.clear();
+  lineStarts_.push_back(0);
+  if (begin_ == end_) {
+    built_ = true;
+    return;
+  }
+  size_t const size = static_cast<size_t>(end_ - begin_);
+  if (memchr(begin_, '\r', size) == nullptr) {
+    char const* current = begin_;
+    while (char const* newline = static_cast<char const*>(
+               memchr(current, '\n', static_cast<size_t>(end_ - current)))) {
+      current = newline + 1;
+      lineStarts_.push_back(static_cast<size_t>(current - begin_));
+    }
+  } else {
+    for (char const* current = begin_; current != end_;) {
+      char const c = *current++;
+      if (c == '\r' && current != end_ && *current == '\n')
+        ++current;
+      if (c == '\r' || c == '\n')
+        lineStarts_.push_back(static_cast<size_t>(current - begin_));
+    }
+  }
+  built_ = true;
+}
+
+/*!
+Finds the last line start at or before the offset with a binary search over the collected line starts.
+*/
+void LineIndex::lineAndColumn(ptrdiff_t offset, int& line,
+                              int& column) const {
+  if (!built_)
+    build();
+  ptrdiff_t const size = end_ - begin_;
+  size_t const position = static_cast<size_t>(
+      offset < 0 ? 0 : (offset > size ? size : offset));
+  auto const next =
+      std::upper_bound(lineStarts_.begin(), lineStarts_.end(), position);
+  line = static_cast<int>(next - lineStarts_.begin());
+  column = static_cast<int>(position - *(next - 1)) + 1;
+}
+
+size_t LineIndex::lineCount() const {
+  if (!built_)
+    build();
+  return lineStarts_.size();
+}
+
 /*!
 Scans the specified range for newline characters ('\n' or '\r') using the standard algorithm std::any_of.
 Returns true if a newline is found, false otherwise.
@@ -399,6 +464,7 @@ void Reader::addComment(Location begin, Location end,
                         CommentPlacement placement) {
   assert(collectComments_);
   const String& normalized = normalizeEOL(begin, end);
+  JSON_NOTE_ALLOCATION(readerComment, normalized.size());
   if (placement == commentAfterOnSameLine) {
     assert(lastValue_ != nullptr);
     lastValue_->setComment(normalized, placement);
@@ -793,6 +859,7 @@ bool Reader::addError(const String& message, Token& token, Location extra) {
   info.message_ = message;
   info.extra_ = extra;
   errors_.push_back(info);
+  JSON_NOTE_ALLOCATION(readerError, sizeof(info) + message.size());
   return false;
 }
 
@@ -883,16 +950,24 @@ String Reader::getFormatedErrorMessages() const {
 /*!
 Constructs a formatted error message string by iterating through collected parsing errors.
 For each error, it includes the error location, message, and any additional details, concatenating them into a single string.
+The locations are looked up in a line index local to the call, so the document is scanned once however many errors there are, and concurrent calls on a const Reader share no state.
 */
 String Reader::getFormattedErrorMessages() const {
+  LineIndex const lineIndex(begin_, end_);
+  auto position = [this, &lineIndex](Location location) {
+    int line, column;
+    lineIndex.lineAndColumn(location - begin_, line, column);
+    char buffer[18 + 16 + 16 + 1];
+    jsoncpp_snprintf(buffer, sizeof(buffer), "Line %d, Column %d", line,
+                     column);
+    return String(buffer);
+  };
   String formattedMessage;
   for (const auto& error : errors_) {
-    formattedMessage +=
-        "* " + getLocationLineAndColumn(error.token_.start_) + "\n";
+    formattedMessage += "* " + position(error.token_.start_) + "\n";
     formattedMessage += "  " + error.message_ + "\n";
     if (error.extra_)
-      formattedMessage +=
-          "See " + getLocationLineAndColumn(error.extra_) + " for detail.\n";
+      formattedMessage += "See " + position(error.extra_) + " for detail.\n";
   }
   return formattedMessage;
 }
@@ -930,6 +1005,7 @@ bool Reader::pushError(const Value& value, const String& message) {
   info.message_ = message;
   info.extra_ = nullptr;
   errors_.push_back(info);
+  JSON_NOTE_ALLOCATION(readerError, sizeof(info) + message.size());
   return true;
 }
 
@@ -952,6 +1028,7 @@ bool Reader::pushError(const Value& value, const String& message,
   info.message_ = message;
   info.extra_ = begin_ + extra.getOffsetStart();
   errors_.push_back(info);
+  JSON_NOTE_ALLOCATION(readerError, sizeof(info) + message.size());
   return true;
 }
 
@@ -990,6 +1067,7 @@ public:
   bool rejectDupKeys_;
   bool allowSpecialFloats_;
   bool skipBom_;
+  bool recycleValues_;
   size_t stackLimit_;
 };
 
@@ -1056,6 +1134,18 @@ public:
   \return A vector of CharReader::StructuredError objects representing all parsing errors encountered.
   */
   std::vector<CharReader::StructuredError> getStructuredErrors() const;
+  /*!
+  \brief Sets the object that later calls to parse() reset and fill in.
+
+  \param stats The object to fill in, or nullptr to stop collecting.
+  */
+  void setStats(ParseStats* stats) { stats_ = stats; }
+  /*!
+  \brief Forgets the last document while keeping the capacity of the internal buffers.
+  
+  Afterwards the reader reports no errors and holds no pointers into the previous input.
+  */
+  void reset();
 
 private:
   OurReader(OurReader const&);
@@ -1110,7 +1200,7 @@ private:
     Location extra_;
   };
 
-  using Errors = std::deque<ErrorInfo>;
+  using Errors = std::vector<ErrorInfo>;
 
   /*!
   \brief Reads and identifies the next token in the JSON input stream.
@@ -1125,6 +1215,14 @@ private:
   */
   bool readToken(Token& token);
   /*!
+  \brief Adds an accepted token to the ParseStats counters.
+
+  Only called when statistics are being collected.
+
+  \param type The type of the token that was read.
+  */
+  void countToken(TokenType type);
+  /*!
   \brief Reads a token while skipping comments.
   
   Reads tokens from the input, skipping any comments if they are allowed by the parser's features.
@@ -1260,6 +1358,21 @@ private:
   */
   bool readArray(Token& token);
   /*!
+  \brief Prepares the current value to receive an array or an object.
+  
+  With the recycleValues feature, a current value that already has the requested type is kept so that its children, keys and strings can be reused; the members of a kept object are marked as not parsed yet.
+  Otherwise the current value is replaced by an empty one of that type.
+  
+  \param type arrayValue or objectValue.
+  
+  \return True if the existing container is reused.
+  */
+  bool beginContainer(ValueType type);
+  /*!
+  \brief Removes the members of a reused object that the document no longer contains.
+  */
+  void dropUnparsedMembers();
+  /*!
   \brief Decodes a numeric token into a JSON value.
   
   Parses the given token as a number and stores it in the current JSON value.
@@ -1476,7 +1589,7 @@ private:
   */
   static bool containsNewLine(Location begin, Location end);
 
-  using Nodes = std::stack<Value*>;
+  using Nodes = std::stack<Value*, std::vector<Value*>>;
 
   Nodes nodes_{};
   Errors errors_{};
@@ -1491,6 +1604,37 @@ private:
 
   OurFeatures const features_;
   bool collectComments_ = false;
+  ParseStats* stats_ = nullptr;
+  LineIndex lineIndex_{};
+  /// Member names and string values are decoded here, so that its capacity
+  /// carries over from one string, and one document, to the next.
+  String decodeBuffer_{};
+};
+
+/*!
+Adds the wall time of its scope to one of the ParseStats phase timings.
+Does nothing, not even read the clock, when constructed without a target.
+*/
+class PhaseTimer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit PhaseTimer(Int64* total) : total_(total) {
+    if (total_)
+      start_ = Clock::now();
+  }
+  ~PhaseTimer() {
+    if (total_)
+      *total_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     Clock::now() - start_)
+                     .count();
+  }
+  PhaseTimer(PhaseTimer const&) = delete;
+  PhaseTimer& operator=(PhaseTimer const&) = delete;
+
+private:
+  Int64* const total_;
+  Clock::time_point start_;
 };
 
 /*!
@@ -1518,6 +1662,10 @@ bool OurReader::parse(const char* beginDoc, const char* endDoc, Value& root,
     collectComments = false;
   }
 
+  if (stats_)
+    *stats_ = ParseStats();
+  PhaseTimer timer(stats_ ? &stats_->parseNanoseconds : nullptr);
+
   begin_ = beginDoc;
   end_ = endDoc;
   collectComments_ = collectComments;
@@ -1531,7 +1679,10 @@ bool OurReader::parse(const char* beginDoc, const char* endDoc, Value& root,
   nodes_.push(&root);
 
   skipBom(features_.skipBom_);
+  lineIndex_.reset(begin_, end_);
   bool successful = readValue();
+  if (stats_)
+    stats_->bytesConsumed = static_cast<size_t>(current_ - begin_);
   nodes_.pop();
   Token token;
   readTokenSkippingComments(token);
@@ -1555,6 +1706,23 @@ bool OurReader::parse(const char* beginDoc, const char* endDoc, Value& root,
   return successful;
 }
 
+/*!
+Clears the per-document state with clear() rather than by reassignment, so the error list, node stack, comment and decode buffers and line index keep their capacity for the next document.
+*/
+void OurReader::reset() {
+  begin_ = nullptr;
+  end_ = nullptr;
+  current_ = nullptr;
+  lastValueEnd_ = nullptr;
+  lastValue_ = nullptr;
+  commentsBefore_.clear();
+  decodeBuffer_.clear();
+  errors_.clear();
+  while (!nodes_.empty())
+    nodes_.pop();
+  lineIndex_.reset(nullptr, nullptr);
+}
+
 /*!
 Parses and constructs a JSON value based on the next token from the input stream.
 Handles various value types, manages comments, and sets offset information for the parsed value.
@@ -1563,10 +1731,22 @@ Returns true if parsing is successful, false otherwise.
 bool OurReader::readValue() {
   if (nodes_.size() > features_.stackLimit_)
     throwRuntimeError("Exceeded stackLimit in readValue().");
+  if (stats_) {
+    ++stats_->nodes;
+    stats_->maxDepth = std::max(stats_->maxDepth, nodes_.size());
+  }
   Token token;
   readTokenSkippingComments(token);
   bool successful = true;
 
+  if (features_.recycleValues_) {
+    Value& value = currentValue();
+    for (int placement = commentBefore; placement != numberOfCommentPlacement;
+         ++placement) {
+      if (value.hasComment(CommentPlacement(placement)))
+        value.setComment(String(), CommentPlacement(placement));
+    }
+  }
   if (collectComments_ && !commentsBefore_.empty()) {
     currentValue().setComment(commentsBefore_, commentBefore);
     commentsBefore_.clear();
@@ -1635,10 +1815,22 @@ bool OurReader::readValue() {
       break;
     }
   default:
+    if (features_.recycleValues_) {
+      Value v;
+      currentValue().swapPayload(v);
+    }
     currentValue().setOffsetStart(token.start_ - begin_);
     currentValue().setOffsetLimit(token.end_ - begin_);
     return addError("Syntax error: value, object or array expected.", token);
   }
+  // A reused value that failed to decode is left null, as a fresh one is.
+  if (!successful && features_.recycleValues_ &&
+      token.type_ != tokenObjectBegin && token.type_ != tokenArrayBegin) {
+    Value v;
+    currentValue().swapPayload(v);
+    currentValue().setOffsetStart(0);
+    currentValue().setOffsetLimit(0);
+  }
 
   if (collectComments_) {
     lastValueEnd_ = current_;
@@ -1774,9 +1966,46 @@ bool OurReader::readToken(Token& token) {
   if (!ok)
     token.type_ = tokenError;
   token.end_ = current_;
+  if (stats_ && ok)
+    countToken(token.type_);
   return ok;
 }
 
+/*!
+Adds a token that readToken() accepted to the ParseStats counters.
+*/
+void OurReader::countToken(TokenType type) {
+  switch (type) {
+  case tokenObjectBegin:
+    ++stats_->objects;
+    break;
+  case tokenArrayBegin:
+    ++stats_->arrays;
+    break;
+  case tokenString:
+    ++stats_->strings;
+    break;
+  case tokenNumber:
+    ++stats_->numbers;
+    break;
+  case tokenTrue:
+  case tokenFalse:
+  case tokenNull:
+    ++stats_->literals;
+    break;
+  case tokenNaN:
+  case tokenPosInf:
+  case tokenNegInf:
+    ++stats_->specialFloats;
+    break;
+  case tokenComment:
+    ++stats_->comments;
+    break;
+  default:
+    break;
+  }
+}
+
 /*!
 Advances the current position in the input stream, skipping over whitespace characters (spaces, tabs, carriage returns, and newlines) until a non-whitespace character is encountered or the end of the stream is reached.
 */
@@ -1887,6 +2116,7 @@ void OurReader::addComment(Location begin, Location end,
                            CommentPlacement placement) {
   assert(collectComments_);
   const String& normalized = normalizeEOL(begin, end);
+  JSON_NOTE_ALLOCATION(readerComment, normalized.size());
   if (placement == commentAfterOnSameLine) {
     assert(lastValue_ != nullptr);
     lastValue_->setComment(normalized, placement);
@@ -1996,56 +2226,72 @@ Populates the current Value object with parsed data, managing errors and recover
 */
 bool OurReader::readObject(Token& token) {
   Token tokenName;
-  String name;
-  Value init(objectValue);
-  currentValue().swapPayload(init);
+  String& name = decodeBuffer_;
+  bool nameEmpty = true;
+  bool const recycled = beginContainer(objectValue);
   currentValue().setOffsetStart(token.start_ - begin_);
+  // Also after an error, so that the partial result matches a fresh value.
+  auto finish = [this, recycled](bool result) {
+    if (recycled)
+      dropUnparsedMembers();
+    return result;
+  };
   while (readTokenSkippingComments(tokenName)) {
     if (tokenName.type_ == tokenObjectEnd &&
-        (name.empty() || features_.allowTrailingCommas_))
-      return true;
+        (nameEmpty || features_.allowTrailingCommas_)) {
+      return finish(true);
+    }
     name.clear();
     if (tokenName.type_ == tokenString) {
       if (!decodeString(tokenName, name))
-        return recoverFromError(tokenObjectEnd);
+        return finish(recoverFromError(tokenObjectEnd));
     } else if (tokenName.type_ == tokenNumber && features_.allowNumericKeys_) {
       Value numberName;
       if (!decodeNumber(tokenName, numberName))
-        return recoverFromError(tokenObjectEnd);
+        return finish(recoverFromError(tokenObjectEnd));
       name = numberName.asString();
     } else {
       break;
     }
+    if (stats_)
+      ++stats_->memberNames;
+    nameEmpty = name.empty();
     if (name.length() >= (1U << 30))
       throwRuntimeError("keylength >= 2^30");
-    if (features_.rejectDupKeys_ && currentValue().isMember(name)) {
+    // Members of a reused object that were not parsed yet are not duplicates.
+    Value const* existing =
+        features_.rejectDupKeys_
+            ? currentValue().find(name.data(), name.data() + name.length())
+            : nullptr;
+    if (existing && existing->getOffsetStart() >= 0) {
       String msg = "Duplicate key: '" + name + "'";
-      return addErrorAndRecover(msg, tokenName, tokenObjectEnd);
+      return finish(addErrorAndRecover(msg, tokenName, tokenObjectEnd));
     }
 
     Token colon;
     if (!readToken(colon) || colon.type_ != tokenMemberSeparator) {
-      return addErrorAndRecover("Missing ':' after object member name", colon,
-                                tokenObjectEnd);
+      return finish(addErrorAndRecover("Missing ':' after object member name",
+                                       colon, tokenObjectEnd));
     }
     Value& value = currentValue()[name];
     nodes_.push(&value);
     bool ok = readValue();
     nodes_.pop();
     if (!ok)
-      return recoverFromError(tokenObjectEnd);
+      return finish(recoverFromError(tokenObjectEnd));
 
     Token comma;
     if (!readTokenSkippingComments(comma) ||
         (comma.type_ != tokenObjectEnd && comma.type_ != tokenArraySeparator)) {
-      return addErrorAndRecover("Missing ',' or '}' in object declaration",
-                                comma, tokenObjectEnd);
+      return finish(addErrorAndRecover(
+          "Missing ',' or '}' in object declaration", comma, tokenObjectEnd));
+    }
+    if (comma.type_ == tokenObjectEnd) {
+      return finish(true);
     }
-    if (comma.type_ == tokenObjectEnd)
-      return true;
   }
-  return addErrorAndRecover("Missing '}' or object member name", tokenName,
-                            tokenObjectEnd);
+  return finish(addErrorAndRecover("Missing '}' or object member name",
+                                   tokenName, tokenObjectEnd));
 }
 
 /*!
@@ -2054,10 +2300,18 @@ Supports features like trailing commas based on parser configuration.
 Manages array construction, error recovery, and proper closing of the array structure.
 */
 bool OurReader::readArray(Token& token) {
-  Value init(arrayValue);
-  currentValue().swapPayload(init);
+  bool const recycled = beginContainer(arrayValue);
   currentValue().setOffsetStart(token.start_ - begin_);
   int index = 0;
+  // Also after an error, so that the partial result matches a fresh value.
+  auto dropUnparsedElements = [this, recycled, &index, &token]() {
+    if (recycled && currentValue().size() > ArrayIndex(index)) {
+      // Shrinking an array to nothing clears it, which also resets its
+      // offsets.
+      currentValue().resize(ArrayIndex(index));
+      currentValue().setOffsetStart(token.start_ - begin_);
+    }
+  };
   for (;;) {
     skipSpaces();
     if (current_ != end_ && *current_ == ']' &&
@@ -2065,29 +2319,66 @@ bool OurReader::readArray(Token& token) {
                         !features_.allowDroppedNullPlaceholders_))) {
       Token endArray;
       readToken(endArray);
-      return true;
+      break;
     }
     Value& value = currentValue()[index++];
     nodes_.push(&value);
     bool ok = readValue();
     nodes_.pop();
-    if (!ok)
+    if (!ok) {
+      dropUnparsedElements();
       return recoverFromError(tokenArrayEnd);
+    }
 
     Token currentToken;
     ok = readTokenSkippingComments(currentToken);
     bool badTokenType = (currentToken.type_ != tokenArraySeparator &&
                          currentToken.type_ != tokenArrayEnd);
     if (!ok || badTokenType) {
+      dropUnparsedElements();
       return addErrorAndRecover("Missing ',' or ']' in array declaration",
                                 currentToken, tokenArrayEnd);
     }
     if (currentToken.type_ == tokenArrayEnd)
       break;
   }
+  dropUnparsedElements();
   return true;
 }
 
+/*!
+Marks the members of a reused object with a negative start offset; readValue() gives every value it parses a real one, so dropUnparsedMembers() can tell the members the document left out.
+Reused array elements need no mark, since the array is cut to the parsed length.
+*/
+bool OurReader::beginContainer(ValueType type) {
+  Value& value = currentValue();
+  if (features_.recycleValues_ && value.type() == type) {
+    if (type == objectValue) {
+      for (Value& member : value)
+        member.setOffsetStart(-1);
+    }
+    return true;
+  }
+  Value init(type);
+  value.swapPayload(init);
+  return false;
+}
+
+/*!
+Walks the object once, removing by name every member still carrying the mark set by beginContainer().
+*/
+void OurReader::dropUnparsedMembers() {
+  Value& object = currentValue();
+  for (auto it = object.begin(); it != object.end();) {
+    auto const member = it++;
+    if (member->getOffsetStart() < 0) {
+      char const* end;
+      char const* begin = member.memberName(&end);
+      object.removeMember(begin, end, nullptr);
+    }
+  }
+}
+
 /*!
 Decodes the numeric token into the current JSON value, updating its payload and offset information.
 Utilizes a helper function for the actual number parsing and returns the success status of the operation.
@@ -2107,6 +2398,7 @@ Parses and converts a JSON number token into an integer or unsigned integer valu
 Handles both positive and negative numbers, switching to double parsing if the number exceeds integer limits or contains non-digit characters.
 */
 bool OurReader::decodeNumber(Token& token, Value& decoded) {
+  PhaseTimer timer(stats_ ? &stats_->numberNanoseconds : nullptr);
   Location current = token.start_;
   const bool isNegative = *current == '-';
   if (isNegative) {
@@ -2161,6 +2453,8 @@ bool OurReader::decodeNumber(Token& token, Value& decoded) {
   } else {
     decoded = value;
   }
+  if (stats_)
+    ++stats_->integers;
 
   return true;
 }
@@ -2197,6 +2491,8 @@ bool OurReader::decodeDouble(Token& token, Value& decoded) {
           "'" + String(token.start_, token.end_) + "' is not a number.", token);
   }
   decoded = value;
+  if (stats_)
+    ++stats_->doubles;
   return true;
 }
 
@@ -2205,11 +2501,11 @@ Decodes the JSON string token, creates a new Value object with the decoded strin
 Sets the offset start and limit for the current value based on the token's position in the input stream.
 */
 bool OurReader::decodeString(Token& token) {
-  String decoded_string;
-  if (!decodeString(token, decoded_string))
+  decodeBuffer_.clear();
+  if (!decodeString(token, decodeBuffer_))
     return false;
-  Value decoded(decoded_string);
-  currentValue().swapPayload(decoded);
+  currentValue().assignString(decodeBuffer_.data(),
+                              decodeBuffer_.data() + decodeBuffer_.length());
   currentValue().setOffsetStart(token.start_ - begin_);
   currentValue().setOffsetLimit(token.end_ - begin_);
   return true;
@@ -2220,6 +2516,7 @@ Processes the input JSON string token, handling escape sequences and Unicode cod
 Iterates through the string, decoding special characters and escape sequences, and converts Unicode code points to UTF-8, storing the result in the output string.
 */
 bool OurReader::decodeString(Token& token, String& decoded) {
+  PhaseTimer timer(stats_ ? &stats_->stringNanoseconds : nullptr);
   decoded.reserve(static_cast<size_t>(token.end_ - token.start_ - 2));
   Location current = token.start_ + 1;
   Location end = token.end_ - 1;
@@ -2228,6 +2525,8 @@ bool OurReader::decodeString(Token& token, String& decoded) {
     if (c == '"')
       break;
     if (c == '\\') {
+      if (stats_)
+        ++stats_->escapes;
       if (current == end)
         return addError("Empty escape sequence in string", token, current);
       Char escape = *current++;
@@ -2340,6 +2639,7 @@ bool OurReader::addError(const String& message, Token& token, Location extra) {
   info.message_ = message;
   info.extra_ = extra;
   errors_.push_back(info);
+  JSON_NOTE_ALLOCATION(readerError, sizeof(info) + message.size());
   return false;
 }
 
@@ -2386,28 +2686,11 @@ OurReader::Char OurReader::getNextChar() {
 }
 
 /*!
-Calculates the line and column numbers for a given location in the JSON document by iterating through the input, tracking line breaks and updating counters.
-Uses character-by-character analysis to determine precise positioning for error reporting purposes.
+Looks the location up in the line index built on the first call, so formatting every error of a document scans it only once.
 */
 void OurReader::getLocationLineAndColumn(Location location, int& line,
                                          int& column) const {
-  Location current = begin_;
-  Location lastLineStart = current;
-  line = 0;
-  while (current < location && current != end_) {
-    Char c = *current++;
-    if (c == '\r') {
-      if (current != end_ && *current == '\n')
-        ++current;
-      lastLineStart = current;
-      ++line;
-    } else if (c == '\n') {
-      lastLineStart = current;
-      ++line;
-    }
-  }
-  column = int(location - lastLineStart) + 1;
-  ++line;
+  lineIndex_.lineAndColumn(location - begin_, line, column);
 }
 
 /*!
@@ -2475,10 +2758,16 @@ public:
   
   \param collectComments Flag indicating whether to collect comments during parsing.
   \param features Parsing options that control the behavior of the JSON reader.
+  \param stats Counters filled in by every parse, or nullptr.
+  */
+  OurCharReader(bool collectComments, OurFeatures const& features,
+                ParseStats* stats)
+      : OurCharReader(new OurImpl(collectComments, features, stats)) {}
+
+  /*!
+  \brief Forgets the last parsed document for CharReader::reset().
   */
-  OurCharReader(bool collectComments, OurFeatures const& features)
-      : CharReader(
-            std::unique_ptr<OurImpl>(new OurImpl(collectComments, features))) {}
+  void resetImpl() { impl_->reset(); }
 
 protected:
   /*!
@@ -2499,9 +2788,13 @@ protected:
     
     \param collectComments Flag indicating whether to collect comments during parsing.
     \param features OurFeatures object specifying the parsing features to be used.
+    \param stats Counters filled in by every parse, or nullptr.
     */
-    OurImpl(bool collectComments, OurFeatures const& features)
-        : collectComments_(collectComments), reader_(features) {}
+    OurImpl(bool collectComments, OurFeatures const& features,
+            ParseStats* stats)
+        : collectComments_(collectComments), reader_(features) {
+      reader_.setStats(stats);
+    }
 
     /*!
     \brief Parses a JSON document.
@@ -2538,10 +2831,22 @@ protected:
       return reader_.getStructuredErrors();
     }
 
+    /*!
+    \brief Forwards the reset to the underlying OurReader, which keeps its buffers.
+    */
+    void reset() { reader_.reset(); }
+
   private:
     bool const collectComments_;
     OurReader reader_;
   };
+
+private:
+  explicit OurCharReader(OurImpl* impl)
+      : CharReader(std::unique_ptr<OurImpl>(impl)), impl_(impl) {}
+
+  /// The implementation owned by the CharReader base, which keeps it private.
+  OurImpl* const impl_;
 };
 
 /*!
@@ -2555,6 +2860,13 @@ Creates a new CharReader instance based on the current settings.
 Configures parsing features such as comment handling, trailing commas, and numeric keys according to the builder's settings, then instantiates and returns a new OurCharReader object with these features.
 */
 CharReader* CharReaderBuilder::newCharReader() const {
+  return newCharReader(nullptr);
+}
+
+/*!
+Hands stats to the reader, which counts into it while it parses.
+*/
+CharReader* CharReaderBuilder::newCharReader(ParseStats* stats) const {
   bool collectComments = settings_["collectComments"].asBool();
   OurFeatures features = OurFeatures::all();
   features.allowComments_ = settings_["allowComments"].asBool();
@@ -2570,7 +2882,8 @@ CharReader* CharReaderBuilder::newCharReader() const {
   features.rejectDupKeys_ = settings_["rejectDupKeys"].asBool();
   features.allowSpecialFloats_ = settings_["allowSpecialFloats"].asBool();
   features.skipBom_ = settings_["skipBom"].asBool();
-  return new OurCharReader(collectComments, features);
+  features.recycleValues_ = settings_["recycleValues"].asBool();
+  return new OurCharReader(collectComments, features, stats);
 }
 
 /*!
@@ -2591,6 +2904,7 @@ bool CharReaderBuilder::validate(Json::Value* invalid) const {
       "rejectDupKeys",
       "allowSpecialFloats",
       "skipBom",
+      "recycleValues",
   };
   for (auto si = settings_.begin(); si != settings_.end(); ++si) {
     auto key = si.name();
@@ -2641,6 +2955,7 @@ void CharReaderBuilder::setDefaults(Json::Value* settings) {
   (*settings)["rejectDupKeys"] = false;
   (*settings)["allowSpecialFloats"] = false;
   (*settings)["skipBom"] = true;
+  (*settings)["recycleValues"] = false;
 }
 /*!
 Configures the provided settings object for strict ECMA-404 JSON parsing.
@@ -2669,6 +2984,14 @@ CharReader::getStructuredErrors() const {
   return _impl->getStructuredErrors();
 }
 
+/*!
+Only readers made by CharReaderBuilder hold per-document state worth forgetting; other implementations are left alone, so Impl needs no virtual for it.
+*/
+void CharReader::reset() {
+  if (auto* reader = dynamic_cast<OurCharReader*>(this))
+    reader->resetImpl();
+}
+
 /*!
 Delegates the parsing of a JSON document to the internal implementation.
 Reads the document from the specified character range, constructs a Value object, and reports any errors encountered during parsing.
@@ -3,6 +3,7 @@
 
 #if !defined(JSON_IS_AMALGAMATION)
 #include <json/config.h>
+#include <json/value.h>
 #endif
 
 #ifdef NO_LOCALE_SUPPORT
@@ -14,6 +15,19 @@
 #endif
 
 namespace Json {
+#if JSON_USE_ALLOCATION_HOOKS
+/*!
+\brief Reports an allocation to the observer installed by setAllocationObserver(), if any.
+
+\param site The code that allocated.
+\param bytes The number of bytes requested.
+*/
+void noteAllocation(AllocationSite site, size_t bytes);
+#define JSON_NOTE_ALLOCATION(site, bytes) Json::noteAllocation(site, bytes)
+#else
+#define JSON_NOTE_ALLOCATION(site, bytes) static_cast<void>(0)
+#endif
+
 /*!
 \brief Retrieves the locale-specific decimal point character.
 
@@ -1,4 +1,5 @@
 #if !defined(JSON_IS_AMALGAMATION)
+#include "json_tool.h"
 #include <json/assertions.h>
 #include <json/value.h>
 #include <json/writer.h>
@@ -7,10 +8,18 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #if defined(_MSC_VER) && _MSC_VER < 1900
 #include <stdarg.h>
@@ -149,6 +158,7 @@ static inline char* duplicateStringValue(const char* value, size_t length) {
     throwRuntimeError("in Json::Value::duplicateStringValue(): "
                       "Failed to allocate string value buffer");
   }
+  JSON_NOTE_ALLOCATION(duplicatedString, length + 1);
   memcpy(newString, value, length);
   newString[length] = 0;
   return newString;
@@ -177,6 +187,7 @@ static inline char* duplicateAndPrefixStringValue(const char* value,
     throwRuntimeError("in Json::Value::duplicateAndPrefixStringValue(): "
                       "Failed to allocate string value buffer");
   }
+  JSON_NOTE_ALLOCATION(prefixedString, actualLength);
   *reinterpret_cast<unsigned*>(newString) = length;
   memcpy(newString + sizeof(unsigned), value, length);
   newString[actualLength - 1U] = 0;
@@ -238,6 +249,212 @@ This function is a wrapper around the standard free() function, simplifying memo
 static inline void releaseStringValue(char* value, unsigned) { free(value); }
 #endif
 
+/*!
+Size reported for one map node: the element plus the colour and the three links of a red-black tree node, as in the common standard library implementations.
+*/
+static size_t const objectValuesNodeSize =
+    sizeof(Value::ObjectValues::value_type) + 4 * sizeof(void*);
+
+#if JSON_USE_ALLOCATION_HOOKS
+static std::atomic<AllocationObserver*> allocationObserver{nullptr};
+
+void noteAllocation(AllocationSite site, size_t bytes) {
+  AllocationObserver* const observer =
+      allocationObserver.load(std::memory_order_acquire);
+  if (observer)
+    observer->allocated(site, bytes);
+}
+#endif
+
+bool setAllocationObserver(AllocationObserver* observer) {
+#if JSON_USE_ALLOCATION_HOOKS
+  allocationObserver.store(observer, std::memory_order_release);
+  return true;
+#else
+  (void)observer;
+  return false;
+#endif
+}
+
+char const* allocationSiteName(AllocationSite site) {
+  switch (site) {
+  case duplicatedString:
+    return "duplicateStringValue";
+  case prefixedString:
+    return "duplicateAndPrefixStringValue";
+  case objectValuesMap:
+    return "ObjectValues";
+  case objectValuesNode:
+    return "ObjectValues node";
+  case commentStorage:
+    return "Comments::set";
+  case readerError:
+    return "reader error";
+  case readerComment:
+    return "reader comment";
+  default:
+    return "unknown";
+  }
+}
+
+AllocationObserver::~AllocationObserver() = default;
+
+AllocationCounter::AllocationCounter() { reset(); }
+
+void AllocationCounter::allocated(AllocationSite site, size_t bytes) {
+  if (site >= numberOfAllocationSites)
+    return;
+  counts_[site].fetch_add(1, std::memory_order_relaxed);
+  bytes_[site].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocationCounter::reset() {
+  for (int site = 0; site < numberOfAllocationSites; ++site) {
+    counts_[site].store(0, std::memory_order_relaxed);
+    bytes_[site].store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t AllocationCounter::count(AllocationSite site) const {
+  return site < numberOfAllocationSites
+             ? counts_[site].load(std::memory_order_relaxed)
+             : 0;
+}
+
+size_t AllocationCounter::bytes(AllocationSite site) const {
+  return site < numberOfAllocationSites
+             ? bytes_[site].load(std::memory_order_relaxed)
+             : 0;
+}
+
+size_t AllocationCounter::totalCount() const {
+  size_t total = 0;
+  for (auto const& count : counts_)
+    total += count.load(std::memory_order_relaxed);
+  return total;
+}
+
+size_t AllocationCounter::totalBytes() const {
+  size_t total = 0;
+  for (auto const& bytes : bytes_)
+    total += bytes.load(std::memory_order_relaxed);
+  return total;
+}
+
+namespace {
+/*!
+\class SerializationCacheRegistry
+\brief Stores the serialized fragments of the values that enabled their serialization cache.
+
+Each such value opens a domain, whose number labels every value of its subtree up to the values that opened domains of their own.
+A domain remembers the domain enclosing it, so that a mutation anywhere below a cached value discards the fragments of every cached ancestor as well.
+Domain numbers are not reused until the 22-bit counter wraps, so values that still carry the number of a closed domain are harmless.
+The registry counts the fragments it holds, so that invalidating a domain takes no lock while nothing is stored.
+*/
+class SerializationCacheRegistry {
+public:
+  static SerializationCacheRegistry& instance() {
+    // Never destroyed, so that values with static storage duration can close
+    // their domain during exit.
+    static auto* registry = new SerializationCacheRegistry();
+    return *registry;
+  }
+
+  unsigned int open(unsigned int parent) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    do {
+      next_ = (next_ + 1) & maxDomain;
+    } while (next_ == 0 || domains_.count(next_) != 0);
+    domains_[next_].parent = parent;
+    return next_;
+  }
+
+  /*!
+  Forgets the domain and returns the domain that enclosed it, or 0.
+  */
+  unsigned int close(unsigned int domain) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = domains_.find(domain);
+    if (it == domains_.end())
+      return 0;
+    unsigned int const parent = it->second.parent;
+    forget(it->second);
+    domains_.erase(it);
+    return parent;
+  }
+
+  void reparent(unsigned int domain, unsigned int parent) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = domains_.find(domain);
+    if (it != domains_.end())
+      it->second.parent = parent;
+  }
+
+  void drop(unsigned int domain) {
+    // A writer storing into this domain or an enclosing one would be reading
+    // the tree that is being mutated, so a zero count cannot be stale here.
+    if (fragmentCount_.load(std::memory_order_relaxed) == 0)
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    invalidate(domain);
+  }
+
+  bool find(unsigned int domain, String const& key, String* fragment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = domains_.find(domain);
+    if (it == domains_.end())
+      return false;
+    auto found = it->second.fragments.find(key);
+    if (found == it->second.fragments.end())
+      return false;
+    *fragment = found->second;
+    return true;
+  }
+
+  void store(unsigned int domain, String const& key, String fragment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = domains_.find(domain);
+    if (it == domains_.end())
+      return;
+    auto const inserted =
+        it->second.fragments.insert(std::make_pair(key, String()));
+    inserted.first->second = std::move(fragment);
+    if (inserted.second)
+      fragmentCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+private:
+  /// The largest number Value::setCacheDomain() keeps.
+  static constexpr unsigned int maxDomain = 0x3fffff;
+
+  struct Domain {
+    unsigned int parent;
+    std::map<String, String> fragments;
+  };
+
+  void invalidate(unsigned int domain) {
+    while (domain != 0) {
+      auto it = domains_.find(domain);
+      if (it == domains_.end())
+        return;
+      forget(it->second);
+      domain = it->second.parent;
+    }
+  }
+
+  void forget(Domain& domain) {
+    fragmentCount_.fetch_sub(domain.fragments.size(),
+                             std::memory_order_relaxed);
+    domain.fragments.clear();
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<unsigned int, Domain> domains_;
+  unsigned int next_ = 0;
+  std::atomic<size_t> fragmentCount_{0};
+};
+} // namespace
+
 } // namespace Json
 
 #if !defined(JSON_IS_AMALGAMATION)
@@ -395,6 +612,7 @@ Value::Value(ValueType type) {
   case arrayValue:
   case objectValue:
     value_.map_ = new ObjectValues();
+    JSON_NOTE_ALLOCATION(objectValuesMap, sizeof(ObjectValues));
     break;
   case booleanValue:
     value_.bool_ = false;
@@ -500,6 +718,8 @@ Value::Value(bool value) {
 Performs a deep copy of the given Json::Value object by duplicating both its payload and metadata, ensuring an independent copy with separate memory allocation for dynamic data.
 */
 Value::Value(const Value& other) {
+  bits_.cacheDomain_ = 0;
+  bits_.cacheRoot_ = false;
   dupPayload(other);
   dupMeta(other);
 }
@@ -518,6 +738,8 @@ Releases the payload and resets the internal value to zero, ensuring proper clea
 Value::~Value() {
   releasePayload();
   value_.uint_ = 0;
+  if (bits_.cacheRoot_)
+    SerializationCacheRegistry::instance().close(cacheDomain());
 }
 
 Value& Value::operator=(const Value& other) {
@@ -531,12 +753,51 @@ Value& Value::operator=(Value&& other) noexcept {
 }
 
 /*!
-Exchanges the internal data representation with another Value object by swapping the bits and value members.
-This operation is performed efficiently without copying or allocating memory.
+Exchanges the internal data representation with another Value object by swapping the type, allocation flag and value members.
+The serialization cache stays with each object. Payloads exchanged within one cache domain, as when sorting or erasing elements, are already labelled with it and only invalidate it; a payload moved out of every domain keeps its labels, which at worst cause spurious invalidations.
 */
 void Value::swapPayload(Value& other) {
-  std::swap(bits_, other.bits_);
+  ValueType const valueType = type();
+  setType(other.type());
+  other.setType(valueType);
+  bool const allocated = isAllocated();
+  setIsAllocated(other.isAllocated());
+  other.setIsAllocated(allocated);
   std::swap(value_, other.value_);
+  if (cacheDomain() == other.cacheDomain()) {
+    invalidateSerializationCache();
+    return;
+  }
+  refreshSerializationCache();
+  other.refreshSerializationCache();
+}
+
+/*!
+Overwrites an owned string buffer in place when the new text is not longer than the old one; the buffer then records the shorter length, so a later longer string allocates again.
+Anything else falls back to swapping in a newly built string payload.
+*/
+void Value::assignString(const char* begin, const char* end) {
+  size_t const length = static_cast<size_t>(end - begin);
+  if (type() == stringValue && isAllocated()) {
+    unsigned oldLength;
+    char const* oldText;
+    decodePrefixedString(true, value_.string_, &oldLength, &oldText);
+    if (length <= oldLength) {
+      char* text = value_.string_ + sizeof(unsigned);
+      memmove(text, begin, length);
+#if JSONCPP_USE_SECURE_MEMORY
+      memset(text + length, 0, oldLength - length + 1U);
+#else
+      text[length] = 0;
+#endif
+      *reinterpret_cast<unsigned*>(value_.string_) =
+          static_cast<unsigned>(length);
+      invalidateSerializationCache();
+      return;
+    }
+  }
+  Value replacement(begin, end);
+  swapPayload(replacement);
 }
 
 /*!
@@ -545,6 +806,7 @@ Releases the current payload and duplicates the payload of the provided Value ob
 void Value::copyPayload(const Value& other) {
   releasePayload();
   dupPayload(other);
+  refreshSerializationCache();
 }
 
 /*!
@@ -580,113 +842,273 @@ Performs a three-way comparison with another JSON value, returning -1 if less th
 The comparison is based on the JSON value types and their contents.
 */
 int Value::compare(const Value& other) const {
-  if (*this < other)
-    return -1;
-  if (*this > other)
-    return 1;
-  return 0;
+  return compareTrees(other, false);
 }
 
 bool Value::operator<(const Value& other) const {
-  int typeDelta = type() - other.type();
-  if (typeDelta)
-    return typeDelta < 0;
-  switch (type()) {
-  case nullValue:
-    return false;
-  case intValue:
-    return value_.int_ < other.value_.int_;
-  case uintValue:
-    return value_.uint_ < other.value_.uint_;
-  case realValue:
-    return value_.real_ < other.value_.real_;
-  case booleanValue:
-    return value_.bool_ < other.value_.bool_;
-  case stringValue: {
-    if ((value_.string_ == nullptr) || (other.value_.string_ == nullptr)) {
-      return other.value_.string_ != nullptr;
-    }
-    unsigned this_len;
-    unsigned other_len;
-    char const* this_str;
-    char const* other_str;
-    decodePrefixedString(this->isAllocated(), this->value_.string_, &this_len,
-                         &this_str);
-    decodePrefixedString(other.isAllocated(), other.value_.string_, &other_len,
-                         &other_str);
-    unsigned min_len = std::min<unsigned>(this_len, other_len);
-    JSON_ASSERT(this_str && other_str);
-    int comp = memcmp(this_str, other_str, min_len);
-    if (comp < 0)
-      return true;
-    if (comp > 0)
-      return false;
-    return (this_len < other_len);
-  }
-  case arrayValue:
-  case objectValue: {
-    auto thisSize = value_.map_->size();
-    auto otherSize = other.value_.map_->size();
-    if (thisSize != otherSize)
-      return thisSize < otherSize;
-    return (*value_.map_) < (*other.value_.map_);
-  }
-  default:
-    JSON_ASSERT_UNREACHABLE;
-  }
-  return false;
+  return compareTrees(other, false) < 0;
 }
 
-bool Value::operator<=(const Value& other) const { return !(other < *this); }
+bool Value::operator<=(const Value& other) const { return compare(other) <= 0; }
 
-bool Value::operator>=(const Value& other) const { return !(*this < other); }
+bool Value::operator>=(const Value& other) const { return compare(other) >= 0; }
 
-bool Value::operator>(const Value& other) const { return other < *this; }
+bool Value::operator>(const Value& other) const { return compare(other) > 0; }
 
 bool Value::operator==(const Value& other) const {
-  if (type() != other.type())
-    return false;
-  switch (type()) {
-  case nullValue:
-    return true;
-  case intValue:
-    return value_.int_ == other.value_.int_;
-  case uintValue:
-    return value_.uint_ == other.value_.uint_;
-  case realValue:
-    return value_.real_ == other.value_.real_;
-  case booleanValue:
-    return value_.bool_ == other.value_.bool_;
-  case stringValue: {
-    if ((value_.string_ == nullptr) || (other.value_.string_ == nullptr)) {
-      return (value_.string_ == other.value_.string_);
+  return compareTrees(other, true) == 0;
+}
+
+namespace {
+template <typename T> int threeWay(T const& left, T const& right) {
+  return left < right ? -1 : (right < left ? 1 : 0);
+}
+
+/*!
+Orders byte strings like memcmp() followed by the lengths; when only equality matters, different lengths settle it before any byte is read.
+*/
+int compareBytes(char const* left, unsigned leftLength, char const* right,
+                 unsigned rightLength, bool equality) {
+  if (left == right && leftLength == rightLength)
+    return 0;
+  if (equality && leftLength != rightLength)
+    return 1;
+  int const comp =
+      memcmp(left, right, std::min<unsigned>(leftLength, rightLength));
+  if (comp != 0)
+    return comp < 0 ? -1 : 1;
+  return threeWay(leftLength, rightLength);
+}
+} // namespace
+
+/*!
+Walks both trees in step, depth first, with one stack frame per pair of containers being compared.
+Each pair of values is first compared without descending: by type, then by scalar contents, or by size for arrays and objects, so differing trees usually stop before any recursion would have started.
+Identical subtrees are skipped when ordering, but not for equality, where a NaN inside a value must still make it differ from itself.
+*/
+int Value::compareTrees(const Value& other, bool equality) const {
+  auto isContainer = [](Value const& value) {
+    return value.type() == arrayValue || value.type() == objectValue;
+  };
+  auto shallow = [equality](Value const& left, Value const& right) -> int {
+    if (left.type() != right.type())
+      return threeWay(left.type(), right.type());
+    switch (left.type()) {
+    case nullValue:
+      return 0;
+    case intValue:
+      return threeWay(left.value_.int_, right.value_.int_);
+    case uintValue:
+      return threeWay(left.value_.uint_, right.value_.uint_);
+    case realValue:
+      if (equality)
+        return left.value_.real_ == right.value_.real_ ? 0 : 1;
+      return threeWay(left.value_.real_, right.value_.real_);
+    case booleanValue:
+      return threeWay(left.value_.bool_, right.value_.bool_);
+    case stringValue: {
+      if (left.value_.string_ == nullptr || right.value_.string_ == nullptr)
+        return threeWay(left.value_.string_ != nullptr,
+                        right.value_.string_ != nullptr);
+      unsigned leftLength;
+      unsigned rightLength;
+      char const* leftText;
+      char const* rightText;
+      decodePrefixedString(left.isAllocated(), left.value_.string_,
+                           &leftLength, &leftText);
+      decodePrefixedString(right.isAllocated(), right.value_.string_,
+                           &rightLength, &rightText);
+      return compareBytes(leftText, leftLength, rightText, rightLength,
+                          equality);
     }
-    unsigned this_len;
-    unsigned other_len;
-    char const* this_str;
-    char const* other_str;
-    decodePrefixedString(this->isAllocated(), this->value_.string_, &this_len,
-                         &this_str);
-    decodePrefixedString(other.isAllocated(), other.value_.string_, &other_len,
-                         &other_str);
-    if (this_len != other_len)
-      return false;
-    JSON_ASSERT(this_str && other_str);
-    int comp = memcmp(this_str, other_str, this_len);
-    return comp == 0;
-  }
-  case arrayValue:
-  case objectValue:
-    return value_.map_->size() == other.value_.map_->size() &&
-           (*value_.map_) == (*other.value_.map_);
-  default:
-    JSON_ASSERT_UNREACHABLE;
+    case arrayValue:
+    case objectValue:
+      return threeWay(left.value_.map_->size(), right.value_.map_->size());
+    default:
+      JSON_ASSERT_UNREACHABLE;
+    }
+    return 0;
+  };
+  auto compareKeys = [equality](CZString const& left,
+                                CZString const& right) -> int {
+    if (!left.data())
+      return threeWay(left.index(), right.index());
+    return compareBytes(left.data(), left.length(), right.data(),
+                        right.length(), equality);
+  };
+  auto descend = [&](Value const& left, Value const& right) {
+    return isContainer(left) && !left.value_.map_->empty() &&
+           (equality || &left != &right);
+  };
+
+  int result = shallow(*this, other);
+  if (result != 0 || !descend(*this, other))
+    return result;
+
+  struct Frame {
+    ObjectValues::const_iterator left;
+    ObjectValues::const_iterator leftEnd;
+    ObjectValues::const_iterator right;
+  };
+  std::vector<Frame> stack;
+  stack.push_back(Frame{value_.map_->begin(), value_.map_->end(),
+                        other.value_.map_->begin()});
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    if (frame.left == frame.leftEnd) {
+      stack.pop_back();
+      continue;
+    }
+    auto const& left = *frame.left++;
+    auto const& right = *frame.right++;
+    result = compareKeys(left.first, right.first);
+    if (result == 0)
+      result = shallow(left.second, right.second);
+    if (result != 0)
+      return result;
+    if (descend(left.second, right.second))
+      stack.push_back(Frame{left.second.value_.map_->begin(),
+                            left.second.value_.map_->end(),
+                            right.second.value_.map_->begin()});
   }
-  return false;
+  return 0;
 }
 
 bool Value::operator!=(const Value& other) const { return !(*this == other); }
 
+namespace {
+// The hash combines 64-bit words with the multiply-xorshift steps of
+// MurmurHash3's finalizer; bytes are read in little-endian order on every
+// platform so that the result does not depend on it.
+LargestUInt const hashSeed = 0x9e3779b97f4a7c15ULL;
+
+inline LargestUInt hashFinish(LargestUInt h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline LargestUInt hashCombine(LargestUInt h, LargestUInt word) {
+  return hashFinish(h ^ (word + hashSeed + (h << 6) + (h >> 2)));
+}
+
+LargestUInt hashBytes(char const* bytes, size_t length) {
+  LargestUInt h = hashCombine(hashSeed, length);
+  auto const* p = reinterpret_cast<unsigned char const*>(bytes);
+  while (length != 0) {
+    size_t const chunk = length < 8 ? length : 8;
+    LargestUInt word = 0;
+    for (size_t i = 0; i < chunk; ++i)
+      word |= static_cast<LargestUInt>(p[i]) << (8 * i);
+    h = hashCombine(h, word);
+    p += chunk;
+    length -= chunk;
+  }
+  return h;
+}
+} // namespace
+
+LargestUInt Value::hash() const { return computeHash(nullptr); }
+
+/*!
+Scalars are hashed directly. Arrays and objects are hashed bottom-up with an explicit stack: a container's hash starts from its type and size, then takes in every member name and member hash in key order, and is stored in the memo when it is finished.
+*/
+LargestUInt
+Value::computeHash(std::unordered_map<Value const*, LargestUInt>* memo) const {
+  auto scalarHash = [](Value const& value) -> LargestUInt {
+    LargestUInt const tag = static_cast<LargestUInt>(value.type());
+    switch (value.type()) {
+    case intValue:
+    case uintValue:
+      return hashCombine(tag, value.value_.uint_);
+    case realValue: {
+      // 0.0 == -0.0, so both must hash alike.
+      double const real = value.value_.real_ == 0.0 ? 0.0 : value.value_.real_;
+      LargestUInt bits;
+      static_assert(sizeof(bits) == sizeof(real), "double is not 64 bits");
+      memcpy(&bits, &real, sizeof(bits));
+      return hashCombine(tag, bits);
+    }
+    case booleanValue:
+      return hashCombine(tag, value.value_.bool_ ? 1 : 0);
+    case stringValue: {
+      if (value.value_.string_ == nullptr)
+        return tag;
+      unsigned length;
+      char const* text;
+      decodePrefixedString(value.isAllocated(), value.value_.string_, &length,
+                           &text);
+      return hashCombine(tag, hashBytes(text, length));
+    }
+    default:
+      return tag;
+    }
+  };
+  auto isContainer = [](Value const& value) {
+    return value.type() == arrayValue || value.type() == objectValue;
+  };
+  auto known = [memo](Value const& value, LargestUInt* found) {
+    if (!memo)
+      return false;
+    auto it = memo->find(&value);
+    if (it == memo->end())
+      return false;
+    *found = it->second;
+    return true;
+  };
+
+  if (!isContainer(*this))
+    return scalarHash(*this);
+  LargestUInt result;
+  if (known(*this, &result))
+    return result;
+
+  struct Frame {
+    Value const* value;
+    ObjectValues::const_iterator next;
+    LargestUInt hash;
+  };
+  auto start = [](Value const& value) {
+    return Frame{&value, value.value_.map_->begin(),
+                 hashCombine(static_cast<LargestUInt>(value.type()),
+                             value.value_.map_->size())};
+  };
+  std::vector<Frame> stack;
+  stack.push_back(start(*this));
+  for (;;) {
+    Frame& frame = stack.back();
+    if (frame.next == frame.value->value_.map_->end()) {
+      LargestUInt const finished = frame.hash;
+      if (memo)
+        (*memo)[frame.value] = finished;
+      stack.pop_back();
+      if (stack.empty())
+        return finished;
+      stack.back().hash = hashCombine(stack.back().hash, finished);
+      continue;
+    }
+    auto const& member = *frame.next++;
+    if (frame.value->type() == objectValue)
+      frame.hash = hashCombine(
+          frame.hash, hashBytes(member.first.data(), member.first.length()));
+    Value const& child = member.second;
+    LargestUInt childHash;
+    if (!isContainer(child))
+      frame.hash = hashCombine(frame.hash, scalarHash(child));
+    else if (known(child, &childHash))
+      frame.hash = hashCombine(frame.hash, childHash);
+    else
+      stack.push_back(start(child));
+  }
+}
+
+LargestUInt ValueHashCache::hash(Value const& value) {
+  return value.computeHash(&hashes_);
+}
+
 /*!
 Retrieves the stored string value as a C-style string pointer, ensuring the Value object contains a string type.
 Decodes the internal string representation using decodePrefixedString to extract the actual string content.
@@ -1065,6 +1487,7 @@ void Value::clear() {
   case arrayValue:
   case objectValue:
     value_.map_->clear();
+    invalidateSerializationCache();
     break;
   default:
     break;
@@ -1090,6 +1513,7 @@ void Value::resize(ArrayIndex newSize) {
     for (ArrayIndex index = newSize; index < oldSize; ++index) {
       value_.map_->erase(index);
     }
+    invalidateSerializationCache();
     JSON_ASSERT(size() == newSize);
   }
 }
@@ -1107,6 +1531,8 @@ Value& Value::operator[](ArrayIndex index) {
 
   ObjectValues::value_type defaultValue(key, nullSingleton());
   it = value_.map_->insert(it, defaultValue);
+  JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
+  adoptIntoSerializationCache((*it).second);
   return (*it).second;
 }
 
@@ -1144,6 +1570,8 @@ Used internally for basic initialization of Value instances.
 void Value::initBasic(ValueType type, bool allocated) {
   setType(type);
   setIsAllocated(allocated);
+  bits_.cacheDomain_ = 0;
+  bits_.cacheRoot_ = false;
   comments_ = Comments{};
   start_ = 0;
   limit_ = 0;
@@ -1178,13 +1606,47 @@ void Value::dupPayload(const Value& other) {
     break;
   case arrayValue:
   case objectValue:
-    value_.map_ = new ObjectValues(*other.value_.map_);
+    dupTree(other);
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
   }
 }
 
+/*!
+Copies one map at a time, appending every entry with an end hint. Scalar children are copied directly; array and object children are created empty and paired with their source on a worklist, so the call depth stays constant however deep the tree is.
+The worklist is local to this call, so copies made meanwhile, such as by an allocation observer, are independent of it.
+Rebuilding costs more than the map's own structural copy, up to twice as much for arrays of small objects, but that copy calls the children's copy constructors, which could only defer their contents through state shared with this call.
+The copy is built in a temporary, so that an allocation failure frees the part already copied.
+*/
+void Value::dupTree(const Value& other) {
+  std::vector<std::pair<Value*, Value const*>> pending;
+  Value copy(other.type());
+  pending.emplace_back(&copy, &other);
+  while (!pending.empty()) {
+    ObjectValues& target = *pending.back().first->value_.map_;
+    ObjectValues const& source = *pending.back().second->value_.map_;
+    pending.pop_back();
+    for (auto const& entry : source) {
+      Value const& child = entry.second;
+      if (child.type() == arrayValue || child.type() == objectValue) {
+        Value& added = target
+                           .emplace_hint(target.end(), std::piecewise_construct,
+                                         std::forward_as_tuple(entry.first),
+                                         std::forward_as_tuple(child.type()))
+                           ->second;
+        added.dupMeta(child);
+        pending.emplace_back(&added, &child);
+      } else {
+        target.emplace_hint(target.end(), entry.first, child);
+      }
+      JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
+    }
+  }
+  value_.map_ = copy.value_.map_;
+  copy.setType(nullValue);
+}
+
 /*!
 Frees memory resources based on the Value's current type.
 For string types, releases allocated string memory if necessary, and for array or object types, deletes the associated map.
@@ -1203,13 +1665,34 @@ void Value::releasePayload() {
     break;
   case arrayValue:
   case objectValue:
-    delete value_.map_;
+    releaseMap(value_.map_);
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
   }
 }
 
+/*!
+Detaches the maps of array and object children onto a stack before deleting their parent's map, so destroying the children never recurses; the stack is only allocated once a nested container is found.
+*/
+void Value::releaseMap(ObjectValues* map) {
+  std::vector<ObjectValues*> pending;
+  for (;;) {
+    for (auto& member : *map) {
+      Value& child = member.second;
+      if (child.type() == arrayValue || child.type() == objectValue) {
+        pending.push_back(child.value_.map_);
+        child.setType(nullValue);
+      }
+    }
+    delete map;
+    if (pending.empty())
+      return;
+    map = pending.back();
+    pending.pop_back();
+  }
+}
+
 /*!
 Copies metadata (comments and position information) from another Value object to this one, used internally for maintaining metadata during Value operations.
 */
@@ -1237,7 +1720,9 @@ Value& Value::resolveReference(const char* key) {
 
   ObjectValues::value_type defaultValue(actualKey, nullSingleton());
   it = value_.map_->insert(it, defaultValue);
+  JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
   Value& value = (*it).second;
+  adoptIntoSerializationCache(value);
   return value;
 }
 
@@ -1260,7 +1745,9 @@ Value& Value::resolveReference(char const* key, char const* end) {
 
   ObjectValues::value_type defaultValue(actualKey, nullSingleton());
   it = value_.map_->insert(it, defaultValue);
+  JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
   Value& value = (*it).second;
+  adoptIntoSerializationCache(value);
   return value;
 }
 
@@ -1302,6 +1789,17 @@ Value const* Value::find(const String& key) const {
   return find(key.data(), key.data() + key.length());
 }
 /*!
+Looks the index up in the element map, so that unassigned elements of sparse arrays are missing rather than aliased to the null singleton.
+*/
+Value const* Value::findIndex(ArrayIndex index) const {
+  if (type() != arrayValue)
+    return nullptr;
+  ObjectValues::const_iterator it = value_.map_->find(CZString(index));
+  if (it == value_.map_->end())
+    return nullptr;
+  return &(*it).second;
+}
+/*!
 Retrieves or creates a nested Value object within the current object, converting it to an objectValue if null.
 Resolves the specified path and returns a pointer to the resulting Value.
 */
@@ -1352,7 +1850,11 @@ Value& Value::append(Value&& value) {
   if (type() == nullValue) {
     *this = Value(arrayValue);
   }
-  return this->value_.map_->emplace(size(), std::move(value)).first->second;
+  Value& appended =
+      this->value_.map_->emplace(size(), std::move(value)).first->second;
+  JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
+  adoptIntoSerializationCache(appended);
+  return appended;
 }
 
 /*!
@@ -1370,17 +1872,69 @@ Checks if the index is valid, moves existing elements, and places the new value
 bool Value::insert(ArrayIndex index, Value&& newValue) {
   JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
                       "in Json::Value::insert: requires arrayValue");
-  ArrayIndex length = size();
-  if (index > length) {
+  if (index > size()) {
     return false;
   }
-  for (ArrayIndex i = length; i > index; i--) {
-    (*this)[i] = std::move((*this)[i - 1]);
-  }
-  (*this)[index] = std::move(newValue);
+  openArrayGap(index, 1)->second = std::move(newValue);
   return true;
 }
 
+/*!
+Appends the new null elements with end hints, then walks both ends of the shifted range backwards together, so every element is found once and moved once.
+*/
+Value::ObjectValues::iterator Value::openArrayGap(ArrayIndex index,
+                                                  ArrayIndex count) {
+  JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
+                      "in Json::Value::insert: requires arrayValue");
+  if (type() == nullValue) {
+    *this = Value(arrayValue);
+  }
+  fillArrayGaps();
+  ArrayIndex const length = size();
+  for (ArrayIndex i = 0; i < count; ++i) {
+    Value& added =
+        value_.map_->emplace_hint(value_.map_->end(), length + i, Value())
+            ->second;
+    JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
+    adoptIntoSerializationCache(added);
+  }
+  auto to = value_.map_->rbegin();
+  auto from = std::next(to, count);
+  for (ArrayIndex i = index; i < length; ++i, ++to, ++from) {
+    to->second.swap(from->second);
+  }
+  return value_.map_->lower_bound(CZString(index));
+}
+
+/*!
+Walks the elements once, inserting the missing ones before each present one with a hint; does nothing when the array has as many entries as elements.
+*/
+void Value::fillArrayGaps() {
+  if (value_.map_->size() == size())
+    return;
+  ArrayIndex next = 0;
+  for (auto it = value_.map_->begin(); it != value_.map_->end(); ++it, ++next) {
+    for (; next < it->first.index(); ++next) {
+      Value& added = value_.map_->emplace_hint(it, next, Value())->second;
+      JSON_NOTE_ALLOCATION(objectValuesNode, objectValuesNodeSize);
+      adoptIntoSerializationCache(added);
+    }
+  }
+}
+
+/*!
+Erases the elements from the given position to the end of the array and invalidates the serialization cache if any were erased.
+*/
+ArrayIndex Value::eraseArrayTail(ObjectValues::iterator from) {
+  auto const erased =
+      static_cast<ArrayIndex>(std::distance(from, value_.map_->end()));
+  if (erased != 0) {
+    value_.map_->erase(from, value_.map_->end());
+    invalidateSerializationCache();
+  }
+  return erased;
+}
+
 /*!
 Searches for a value using the provided key range and returns the found value or the default value if not found.
 Utilizes the `find` method internally to locate the requested key.
@@ -1421,6 +1975,7 @@ bool Value::removeMember(const char* begin, const char* end, Value* removed) {
   if (removed)
     *removed = std::move(it->second);
   value_.map_->erase(it);
+  invalidateSerializationCache();
   return true;
 }
 /*!
@@ -1449,7 +2004,8 @@ void Value::removeMember(const char* key) {
     return;
 
   CZString actualKey(key, unsigned(strlen(key)), CZString::noDuplication);
-  value_.map_->erase(actualKey);
+  if (value_.map_->erase(actualKey) != 0)
+    invalidateSerializationCache();
 }
 /*!
 Delegates the removal of a member from the JSON object to the main implementation by converting the string key to a C-style string.
@@ -1470,19 +2026,39 @@ bool Value::removeIndex(ArrayIndex index, Value* removed) {
   if (it == value_.map_->end()) {
     return false;
   }
+  if (value_.map_->size() != size()) {
+    fillArrayGaps();
+    it = value_.map_->find(key);
+  }
   if (removed)
     *removed = std::move(it->second);
-  ArrayIndex oldSize = size();
-  for (ArrayIndex i = index; i < (oldSize - 1); ++i) {
-    CZString keey(i);
-    (*value_.map_)[keey] = (*this)[i + 1];
+  for (auto next = std::next(it); next != value_.map_->end(); ++it, ++next) {
+    it->second.swap(next->second);
   }
-  CZString keyLast(oldSize - 1);
-  auto itLast = value_.map_->find(keyLast);
-  value_.map_->erase(itLast);
+  eraseArrayTail(it);
   return true;
 }
 
+/*!
+Moves the elements after the range down over it in one pass, then drops the vacated slots from the end.
+*/
+ArrayIndex Value::eraseRange(ArrayIndex begin, ArrayIndex end) {
+  if (type() != arrayValue) {
+    return 0;
+  }
+  end = std::min(end, size());
+  if (begin >= end) {
+    return 0;
+  }
+  fillArrayGaps();
+  auto to = value_.map_->lower_bound(CZString(begin));
+  for (auto from = value_.map_->lower_bound(CZString(end));
+       from != value_.map_->end(); ++to, ++from) {
+    to->second.swap(from->second);
+  }
+  return eraseArrayTail(to);
+}
+
 /*!
 Checks for the existence of a member within the specified character range by searching for a matching value.
 Returns true if a member is found, false otherwise.
@@ -1700,7 +2276,10 @@ bool Value::isObject() const { return type() == objectValue; }
 Performs a deep copy of the provided Comments object, creating a new instance with its own independent copy of the comment data using the cloneUnique function.
 */
 Value::Comments::Comments(const Comments& that)
-    : ptr_{cloneUnique(that.ptr_)} {}
+    : ptr_{cloneUnique(that.ptr_)} {
+  if (ptr_)
+    JSON_NOTE_ALLOCATION(commentStorage, sizeof(Array));
+}
 
 /*!
 Moves the comment data from the source object to the newly constructed object, transferring ownership of the resources.
@@ -1711,6 +2290,8 @@ Value::Comments::Comments(Comments&& that) noexcept
 
 Value::Comments& Value::Comments::operator=(const Comments& that) {
   ptr_ = cloneUnique(that.ptr_);
+  if (ptr_)
+    JSON_NOTE_ALLOCATION(commentStorage, sizeof(Array));
   return *this;
 }
 
@@ -1744,11 +2325,28 @@ Creates internal storage if necessary and moves the provided comment string into
 void Value::Comments::set(CommentPlacement slot, String comment) {
   if (slot >= CommentPlacement::numberOfCommentPlacement)
     return;
-  if (!ptr_)
+  if (!ptr_) {
     ptr_ = std::unique_ptr<Array>(new Array());
+    JSON_NOTE_ALLOCATION(commentStorage, sizeof(Array));
+  }
   (*ptr_)[slot] = std::move(comment);
 }
 
+/*!
+Counts the array of slots plus the buffer of every comment too long for the string's inline storage.
+*/
+size_t Value::Comments::heapBytes() const {
+  if (!ptr_)
+    return 0;
+  size_t const inlineCapacity = String().capacity();
+  size_t bytes = sizeof(Array);
+  for (String const& comment : *ptr_) {
+    if (comment.capacity() > inlineCapacity)
+      bytes += comment.capacity() + 1;
+  }
+  return bytes;
+}
+
 /*!
 Sets the comment for the JSON value at the specified placement.
 Removes any trailing newline from the comment, ensures it starts with a forward slash, and uses the internal Comments structure to store the comment.
@@ -1761,6 +2359,7 @@ void Value::setComment(String comment, CommentPlacement placement) {
       comment.empty() || comment[0] == '/',
       "in Json::Value::setComment(): Comments must start with /");
   comments_.set(placement, std::move(comment));
+  invalidateSerializationCache();
 }
 
 /*!
@@ -1803,6 +2402,279 @@ This offset is used to define the span of a JSON value for parsing and error rep
 */
 ptrdiff_t Value::getOffsetLimit() const { return limit_; }
 
+MemoryUsage Value::memoryUsage() const {
+  MemoryUsage usage;
+  addMemoryUsage(usage);
+  return usage;
+}
+
+/*!
+Walks the tree with an explicit stack of values and their depths, counting every value itself and then its heap payload.
+Containers are counted as the map object plus, for every element, its node without the child Value, which the child counts itself.
+*/
+void Value::addMemoryUsage(MemoryUsage& usage) const {
+  std::vector<std::pair<Value const*, size_t>> pending;
+  pending.emplace_back(this, 1);
+  while (!pending.empty()) {
+    Value const& value = *pending.back().first;
+    size_t const depth = pending.back().second;
+    pending.pop_back();
+    ++usage.nodes;
+    ++usage.countByType[value.type()];
+    usage.maxDepth = std::max(usage.maxDepth, depth);
+    usage.valueBytes += sizeof(Value);
+    usage.commentBytes += value.comments_.heapBytes();
+    switch (value.type()) {
+    case stringValue:
+      if (value.value_.string_ && value.isAllocated()) {
+        unsigned length;
+        char const* str;
+        decodePrefixedString(true, value.value_.string_, &length, &str);
+        usage.stringBytes += sizeof(unsigned) + length + 1;
+      }
+      break;
+    case arrayValue:
+    case objectValue:
+      usage.mapBytes += sizeof(ObjectValues);
+      if (value.type() == objectValue)
+        usage.objectMembers += value.value_.map_->size();
+      for (auto const& entry : *value.value_.map_) {
+        usage.mapBytes += objectValuesNodeSize - sizeof(Value);
+        if (entry.first.data() && !entry.first.isStaticString())
+          usage.keyBytes += entry.first.length() + 1;
+        pending.emplace_back(&entry.second, depth + 1);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+/*!
+\class ValueReclaimer::Impl
+\brief The queue and thread of a ValueReclaimer.
+
+The queue is a vector whose capacity is reserved up front, so queuing never allocates; the thread swaps it with a second reserved vector and frees the batch without holding the lock.
+The trees of that batch still count against the capacity until they are freed, so the queue and the batch together never hold more than capacity trees.
+Trees are freed in the order they were queued, so the deferred count taken when drain() starts is reached once everything queued before it has been freed.
+*/
+class ValueReclaimer::Impl {
+public:
+  explicit Impl(size_t capacity) {
+    stats_.capacity = capacity ? capacity : 1;
+    queue_.reserve(stats_.capacity);
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  bool enqueue(Value& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() + freeing_ >= stats_.capacity) {
+      ++stats_.releasedInline;
+      return false;
+    }
+    if (!thread_.joinable())
+      thread_ = std::thread(&Impl::run, this);
+    queue_.emplace_back(std::move(value));
+    ++stats_.deferred;
+    stats_.pending = queue_.size() + freeing_;
+    stats_.highWater = std::max(stats_.highWater, stats_.pending);
+    wake_.notify_one();
+    return true;
+  }
+
+  void countInline() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.releasedInline;
+  }
+
+  void drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t const queued = stats_.deferred;
+    freed_.wait(lock, [this, queued] { return stats_.reclaimed >= queued; });
+  }
+
+  ReclaimerStats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+private:
+  void run() {
+    std::vector<Value> batch;
+    batch.reserve(stats_.capacity);
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty())
+        return;
+      batch.swap(queue_);
+      freeing_ = batch.size();
+      lock.unlock();
+      batch.clear();
+      lock.lock();
+      stats_.reclaimed += freeing_;
+      freeing_ = 0;
+      stats_.pending = queue_.size();
+      freed_.notify_all();
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable freed_;
+  std::vector<Value> queue_;
+  size_t freeing_ = 0;
+  bool stopping_ = false;
+  ReclaimerStats stats_;
+  std::thread thread_;
+};
+
+ValueReclaimer::ValueReclaimer(size_t capacity)
+    : impl_(new Impl(capacity)) {}
+
+ValueReclaimer::~ValueReclaimer() = default;
+
+/*!
+Only trees holding an array or object are queued; anything else is freed right away, as that costs no more than queuing it.
+*/
+void ValueReclaimer::release(Value&& value) {
+  if ((value.type() == arrayValue || value.type() == objectValue) &&
+      !value.empty()) {
+    if (impl_->enqueue(value))
+      return;
+  } else {
+    impl_->countInline();
+  }
+  Value released(std::move(value));
+}
+
+void ValueReclaimer::drain() { impl_->drain(); }
+
+ReclaimerStats ValueReclaimer::stats() const { return impl_->stats(); }
+
+ValueReclaimer& ValueReclaimer::shared() {
+  static auto* reclaimer = new ValueReclaimer();
+  return *reclaimer;
+}
+
+void deferredRelease(Value&& value) {
+  ValueReclaimer::shared().release(std::move(value));
+}
+
+/*!
+Opens a cache domain nested in the one this value belongs to and labels the subtree with it.
+*/
+void Value::enableSerializationCache() {
+  if (bits_.cacheRoot_)
+    return;
+  unsigned int const domain =
+      SerializationCacheRegistry::instance().open(cacheDomain());
+  setCacheDomain(domain);
+  bits_.cacheRoot_ = true;
+  labelSerializationCache(domain);
+}
+
+/*!
+Closes the cache domain of this value and hands the subtree back to the enclosing domain.
+*/
+void Value::disableSerializationCache() {
+  if (!bits_.cacheRoot_)
+    return;
+  unsigned int const parent =
+      SerializationCacheRegistry::instance().close(cacheDomain());
+  setCacheDomain(parent);
+  bits_.cacheRoot_ = false;
+  labelSerializationCache(parent);
+}
+
+bool Value::findCachedSerialization(String const& key,
+                                    String* fragment) const {
+  if (!bits_.cacheRoot_)
+    return false;
+  return SerializationCacheRegistry::instance().find(cacheDomain(), key,
+                                                     fragment);
+}
+
+void Value::storeCachedSerialization(String const& key,
+                                     String fragment) const {
+  if (!bits_.cacheRoot_)
+    return;
+  SerializationCacheRegistry::instance().store(cacheDomain(), key,
+                                               std::move(fragment));
+}
+
+void Value::dropCachedSerializations(unsigned int domain) {
+  SerializationCacheRegistry::instance().drop(domain);
+}
+
+/*!
+Children that already carry the domain are skipped: a value and the values below it are always relabelled together, so their subtrees carry it too.
+The stack only allocates once a relabelled child has children of its own.
+*/
+void Value::labelSerializationCache(unsigned int domain) {
+  std::vector<Value*> pending;
+  Value* node = this;
+  for (;;) {
+    if (node->type() == arrayValue || node->type() == objectValue) {
+      for (auto& member : *node->value_.map_) {
+        Value& child = member.second;
+        if (child.bits_.cacheRoot_) {
+          SerializationCacheRegistry::instance().reparent(child.cacheDomain(),
+                                                          domain);
+        } else if (child.cacheDomain() != domain) {
+          child.setCacheDomain(domain);
+          if ((child.type() == arrayValue || child.type() == objectValue) &&
+              !child.value_.map_->empty())
+            pending.push_back(&child);
+        }
+      }
+    }
+    if (pending.empty())
+      return;
+    node = pending.back();
+    pending.pop_back();
+  }
+}
+
+void Value::refreshSerializationCache() {
+  if (cacheDomain() == 0)
+    return;
+  labelSerializationCache(cacheDomain());
+  dropCachedSerializations(cacheDomain());
+}
+
+void Value::adoptIntoSerializationCache(Value& child) {
+  if (cacheDomain() == 0)
+    return;
+  child.setCacheDomain(cacheDomain());
+  child.labelSerializationCache(cacheDomain());
+  dropCachedSerializations(cacheDomain());
+}
+
+namespace {
+/// The data members of Value before the serialization cache was added.
+struct UncachedValueLayout {
+  Value::LargestUInt payload;
+  unsigned int bits;
+  std::unique_ptr<String> comments;
+  ptrdiff_t start;
+  ptrdiff_t limit;
+};
+} // namespace
+
+static_assert(sizeof(Value) == sizeof(UncachedValueLayout),
+              "the serialization cache must not change the size of Value");
+
 /*!
 Generates a formatted string representation of the JSON value, including any associated comments.
 Utilizes a StreamWriterBuilder for customizable output formatting and appends newline characters for improved readability.
@@ -2046,4 +2918,338 @@ Value& Path::make(Value& root) const {
   return *node;
 }
 
+/*!
+Copies the arguments of the path into steps, measuring and hashing every member name once.
+*/
+CompiledPath::CompiledPath(const Path& path) {
+  steps_.reserve(path.args_.size());
+  for (const auto& arg : path.args_) {
+    Step step;
+    if (arg.kind_ == PathArgument::kindIndex) {
+      step.index = arg.index_;
+    } else if (arg.kind_ == PathArgument::kindKey) {
+      step.key = arg.key_;
+      step.hash = hashBytes(step.key.data(), step.key.size());
+      step.isKey = true;
+    } else {
+      continue;
+    }
+    steps_.push_back(std::move(step));
+  }
+}
+
+CompiledPath::CompiledPath(const String& path) : CompiledPath(Path(path)) {}
+
+/*!
+Looks a member up by its stored bounds, or an index among the stored elements, returning nullptr instead of asserting on a node of the wrong type.
+*/
+Value const* CompiledPath::Step::apply(const Value& node) const {
+  if (isKey)
+    return node.isObject() ? node.find(key.data(), key.data() + key.size())
+                           : nullptr;
+  return node.findIndex(index);
+}
+
+bool CompiledPath::Step::operator==(const Step& other) const {
+  if (isKey != other.isKey)
+    return false;
+  if (!isKey)
+    return index == other.index;
+  return hash == other.hash && key == other.key;
+}
+
+Value const* CompiledPath::find(const Value& root) const {
+  Value const* node = &root;
+  for (const auto& step : steps_) {
+    node = step.apply(*node);
+    if (!node)
+      return nullptr;
+  }
+  return node;
+}
+
+const Value& CompiledPath::resolve(const Value& root) const {
+  Value const* found = find(root);
+  return found ? *found : Value::nullSingleton();
+}
+
+CompiledPathSet::CompiledPathSet(CompiledPath const* paths, size_t count) {
+  build(paths, count);
+}
+
+CompiledPathSet::CompiledPathSet(std::vector<CompiledPath> const& paths) {
+  build(paths.data(), paths.size());
+}
+
+/*!
+Merges the paths into a tree whose children are found by comparing the step hashes first, then lays the tree out in preorder so that resolving is a single forward walk that jumps over the subtree of every step that fails.
+*/
+void CompiledPathSet::build(CompiledPath const* paths, size_t count) {
+  struct TreeNode {
+    CompiledPath::Step step;
+    std::vector<size_t> children;
+    std::vector<size_t> ends;
+  };
+  std::vector<TreeNode> tree(1);
+  for (size_t path = 0; path < count; ++path) {
+    size_t current = 0;
+    for (const auto& step : paths[path].steps_) {
+      size_t next = 0;
+      for (size_t child : tree[current].children) {
+        if (tree[child].step == step) {
+          next = child;
+          break;
+        }
+      }
+      if (next == 0) {
+        next = tree.size();
+        tree[current].children.push_back(next);
+        tree.push_back(TreeNode{step, {}, {}});
+      }
+      current = next;
+    }
+    tree[current].ends.push_back(path);
+  }
+
+  pathCount_ = count;
+  nodes_.clear();
+  ends_.clear();
+  nodes_.reserve(tree.size());
+  ends_.reserve(count);
+  std::vector<std::pair<size_t, size_t>> pending{{0, 0}};
+  while (!pending.empty()) {
+    size_t const source = pending.back().first;
+    Node node;
+    node.step = tree[source].step;
+    node.parent = pending.back().second;
+    node.firstEnd = ends_.size();
+    node.endCount = tree[source].ends.size();
+    pending.pop_back();
+    ends_.insert(ends_.end(), tree[source].ends.begin(),
+                 tree[source].ends.end());
+    size_t const index = nodes_.size();
+    nodes_.push_back(std::move(node));
+    auto const& children = tree[source].children;
+    for (auto child = children.rbegin(); child != children.rend(); ++child)
+      pending.emplace_back(*child, index);
+  }
+  // Children follow their parent in preorder, so walking backwards
+  // finishes every subtree before its parent reads its end.
+  for (size_t i = nodes_.size(); i-- > 0;) {
+    nodes_[i].subtreeEnd = std::max(nodes_[i].subtreeEnd, i + 1);
+    if (i != 0)
+      nodes_[nodes_[i].parent].subtreeEnd =
+          std::max(nodes_[nodes_[i].parent].subtreeEnd, nodes_[i].subtreeEnd);
+  }
+}
+
+/*!
+Keeps the value reached by every step in a per-thread buffer, so each step starts from its parent's value without a stack, and skips the whole subtree of a step that finds nothing.
+*/
+void CompiledPathSet::resolveMany(const Value& root, Value const** out) const {
+  static thread_local std::vector<Value const*> reached;
+  if (reached.size() < nodes_.size())
+    reached.resize(nodes_.size());
+  std::fill(out, out + pathCount_, nullptr);
+  for (size_t i = 0; i < nodes_.size();) {
+    Node const& node = nodes_[i];
+    Value const* value =
+        i == 0 ? &root : node.step.apply(*reached[node.parent]);
+    if (!value) {
+      i = node.subtreeEnd;
+      continue;
+    }
+    reached[i] = value;
+    for (size_t end = node.firstEnd; end != node.firstEnd + node.endCount;
+         ++end)
+      out[ends_[end]] = value;
+    ++i;
+  }
+}
+
+namespace {
+/// A reference token of a JSON Pointer, still escaped, without its '/'.
+struct PointerToken {
+  char const* begin;
+  char const* end;
+  bool escaped;
+};
+
+/*!
+Reads the token that starts after the '/' at cursor and moves cursor to the next '/' or to the end.
+Returns false at the end of the pointer or on a '~' not followed by '0' or '1'; valid is cleared in the latter case.
+*/
+bool nextPointerToken(char const*& cursor, char const* end,
+                      PointerToken& token, bool& valid) {
+  if (cursor == end)
+    return false;
+  if (*cursor != '/') {
+    valid = false;
+    return false;
+  }
+  token.begin = ++cursor;
+  auto const slash =
+      static_cast<char const*>(memchr(cursor, '/', size_t(end - cursor)));
+  token.end = slash ? slash : end;
+  token.escaped = false;
+  for (char const* c = token.begin; c != token.end; ++c) {
+    if (*c != '~')
+      continue;
+    if (c + 1 == token.end || (c[1] != '0' && c[1] != '1')) {
+      valid = false;
+      return false;
+    }
+    token.escaped = true;
+  }
+  cursor = token.end;
+  return true;
+}
+
+size_t unescapePointerToken(PointerToken const& token, char* out) {
+  char* const start = out;
+  for (char const* c = token.begin; c != token.end; ++c) {
+    if (*c == '~')
+      *out++ = *++c == '0' ? '~' : '/';
+    else
+      *out++ = *c;
+  }
+  return size_t(out - start);
+}
+
+/*!
+Calls use with the bounds of the unescaped token, pointing into the pointer itself when the token has no escapes and into a stack buffer otherwise.
+*/
+template <typename Use>
+auto withPointerKey(PointerToken const& token, Use use)
+    -> decltype(use(token.begin, token.end)) {
+  if (!token.escaped)
+    return use(token.begin, token.end);
+  char buffer[128];
+  size_t const length = size_t(token.end - token.begin);
+  if (length <= sizeof(buffer))
+    return use(buffer, buffer + unescapePointerToken(token, buffer));
+  String key(length, '\0');
+  size_t const keyLength = unescapePointerToken(token, &key[0]);
+  return use(key.data(), key.data() + keyLength);
+}
+
+bool isPointerAppend(PointerToken const& token) {
+  return token.end - token.begin == 1 && *token.begin == '-';
+}
+
+bool parsePointerIndex(PointerToken const& token, ArrayIndex& index) {
+  if (token.begin == token.end ||
+      (*token.begin == '0' && token.end - token.begin > 1))
+    return false;
+  index = 0;
+  for (char const* c = token.begin; c != token.end; ++c) {
+    if (*c < '0' || *c > '9')
+      return false;
+    auto const digit = ArrayIndex(*c - '0');
+    if (index > (std::numeric_limits<ArrayIndex>::max() - digit) / 10)
+      return false;
+    index = index * 10 + digit;
+  }
+  return true;
+}
+
+Value const* pointerChild(Value const& node, PointerToken const& token) {
+  if (node.isObject())
+    return withPointerKey(token, [&node](char const* begin, char const* end) {
+      return node.find(begin, end);
+    });
+  ArrayIndex index;
+  if (node.isArray() && parsePointerIndex(token, index))
+    return node.findIndex(index);
+  return nullptr;
+}
+
+/*!
+Walks every token but the last, which is returned in last; returns nullptr if the pointer is invalid, empty or leaves the document before its last token.
+*/
+Value const* pointerParent(Value const& root, StringView pointer,
+                           PointerToken& last) {
+  char const* cursor = pointer.begin();
+  char const* const end = pointer.end();
+  bool valid = true;
+  if (!nextPointerToken(cursor, end, last, valid))
+    return nullptr;
+  Value const* node = &root;
+  PointerToken token;
+  while (nextPointerToken(cursor, end, token, valid)) {
+    node = pointerChild(*node, last);
+    if (!node)
+      return nullptr;
+    last = token;
+  }
+  return valid ? node : nullptr;
+}
+} // namespace
+
+bool Pointer::isValid(StringView pointer) {
+  char const* cursor = pointer.begin();
+  bool valid = true;
+  PointerToken token;
+  while (nextPointerToken(cursor, pointer.end(), token, valid)) {
+  }
+  return valid;
+}
+
+Value const* Pointer::resolve(const Value& root, StringView pointer) {
+  if (pointer.empty())
+    return &root;
+  PointerToken last;
+  Value const* parent = pointerParent(root, pointer, last);
+  return parent ? pointerChild(*parent, last) : nullptr;
+}
+
+Value* Pointer::resolve(Value& root, StringView pointer) {
+  return const_cast<Value*>(resolve(static_cast<Value const&>(root), pointer));
+}
+
+/*!
+Checks the whole pointer first, so that a syntax error creates nothing, then walks it creating members and elements as it goes.
+*/
+Value* Pointer::make(Value& root, StringView pointer) {
+  if (!isValid(pointer))
+    return nullptr;
+  char const* cursor = pointer.begin();
+  bool valid = true;
+  PointerToken token;
+  Value* node = &root;
+  while (nextPointerToken(cursor, pointer.end(), token, valid)) {
+    if (node->isNull())
+      *node = Value(isPointerAppend(token) ? arrayValue : objectValue);
+    if (node->isObject()) {
+      node = withPointerKey(token, [node](char const* begin, char const* end) {
+        return node->demand(begin, end);
+      });
+    } else if (node->isArray()) {
+      ArrayIndex index = node->size();
+      if (!isPointerAppend(token) &&
+          (!parsePointerIndex(token, index) || index > node->size()))
+        return nullptr;
+      node = &(*node)[index];
+    } else {
+      return nullptr;
+    }
+  }
+  return node;
+}
+
+bool Pointer::remove(Value& root, StringView pointer, Value* removed) {
+  PointerToken last;
+  auto parent = const_cast<Value*>(pointerParent(root, pointer, last));
+  if (!parent)
+    return false;
+  if (parent->isObject())
+    return withPointerKey(
+        last, [parent, removed](char const* begin, char const* end) {
+          return parent->removeMember(begin, end, removed);
+        });
+  ArrayIndex index;
+  return parent->isArray() && parsePointerIndex(last, index) &&
+         parent->removeIndex(index, removed);
+}
+
 } // namespace Json
@@ -90,7 +90,7 @@ Retrieves the index of the current element in the JSON object.
 Returns the numeric index for elements with numeric keys, or -1 (as UInt) for elements with string keys.
 */
 UInt ValueIteratorBase::index() const {
-  const Value::CZString czstring = (*current_).first;
+  const Value::CZString& czstring = (*current_).first;
   if (!czstring.data())
     return czstring.index();
   return Value::UInt(-1);
@@ -109,6 +109,16 @@ String ValueIteratorBase::name() const {
   return String(keey, end);
 }
 
+/*!
+Points the view at the key stored in the map, so nothing is copied; array keys have no characters and give an empty view.
+*/
+StringView ValueIteratorBase::keyView() const {
+  Value::CZString const& key = (*current_).first;
+  if (!key.data())
+    return StringView();
+  return StringView(key.data(), key.length());
+}
+
 /*!
 Retrieves the name of the current member in the JSON object iteration.
 Returns a pointer to the member's key as a C-style string, or an empty string if the key is null.
@@ -1,15 +1,22 @@
 #if !defined(JSON_IS_AMALGAMATION)
 #include "json_tool.h"
+#include <json/assertions.h>
 #include <json/writer.h>
 #endif
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cctype>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <iomanip>
 #include <memory>
 #include <set>
 #include <sstream>
+#include <system_error>
+#include <thread>
 #include <utility>
 
 #if __cplusplus >= 201103L
@@ -357,7 +364,7 @@ static String valueToQuotedStringN(const char* value, size_t length,
     return "";
 
   if (!doesAnyCharRequireEscaping(value, length))
-    return String("\"") + value + "\"";
+    return String("\"").append(value, length).append("\"");
   String::size_type maxsize = length * 2 + 3;
   String result;
   result.reserve(maxsize);
@@ -415,6 +422,183 @@ static String valueToQuotedStringN(const char* value, size_t length,
   return result;
 }
 
+/*!
+Counts the escape sequences valueToQuotedStringN() emits for a string; a character outside the Basic Multilingual Plane written as a surrogate pair counts twice.
+*/
+static size_t escapeSequenceCount(char const* value, size_t length,
+                                  bool emitUTF8) {
+  if (value == nullptr || !doesAnyCharRequireEscaping(value, length))
+    return 0;
+  size_t result = 0;
+  char const* end = value + length;
+  for (char const* c = value; c != end; ++c) {
+    unsigned codepoint = static_cast<unsigned char>(*c);
+    if (codepoint >= 0x80 && !emitUTF8)
+      codepoint = utf8ToCodepoint(c, end);
+    if (codepoint < 0x20 || codepoint == '"' || codepoint == '\\')
+      ++result;
+    else if (codepoint >= 0x80 && !emitUTF8)
+      result += codepoint < 0x10000 ? 1 : 2;
+  }
+  return result;
+}
+
+namespace {
+/*!
+\class WriteStatsRecorder
+\brief Fills in the WriteStats of a writer while it writes.
+
+The writer reports every value it formats, and the recorder keeps the nesting depth between enter() and leave().
+Every member does nothing when the writer has no statistics object, so writes without statistics only pay for a null check per value.
+*/
+class WriteStatsRecorder {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  WriteStatsRecorder(WriteStats* stats, bool emitUTF8)
+      : stats_(stats), emitUTF8_(emitUTF8) {}
+
+  WriteStats* stats() const { return stats_; }
+  /// Sends the counters to another object, as the workers of a parallel
+  /// write do before merging them.
+  void redirect(WriteStats* stats) { stats_ = stats; }
+
+  /// Resets the counters before a write to sout.
+  void begin(OStream* sout) {
+    if (!stats_)
+      return;
+    *stats_ = WriteStats();
+    depth_ = 0;
+    startPosition_ = sout->tellp();
+    start_ = Clock::now();
+  }
+
+  /// Records the elapsed time and the bytes written to sout since begin().
+  void finish(OStream* sout) {
+    if (!stats_)
+      return;
+    stats_->writeNanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                             start_)
+            .count();
+    std::streampos const endPosition = sout->tellp();
+    if (startPosition_ != std::streampos(-1) &&
+        endPosition != std::streampos(-1))
+      stats_->bytesWritten = static_cast<size_t>(endPosition - startPosition_);
+  }
+
+  /// Counts a value about to be formatted; strings count their escapes.
+  void value(Value const& value) {
+    if (!stats_)
+      return;
+    ++stats_->nodes;
+    stats_->maxDepth = std::max(stats_->maxDepth, depth_ + 1);
+    switch (value.type()) {
+    case nullValue:
+    case booleanValue:
+      ++stats_->literals;
+      break;
+    case intValue:
+    case uintValue:
+      ++stats_->integers;
+      break;
+    case realValue:
+      ++stats_->reals;
+      break;
+    case stringValue: {
+      char const* str;
+      char const* end;
+      if (value.getString(&str, &end))
+        string(str, end);
+    } break;
+    case arrayValue:
+      ++stats_->arrays;
+      break;
+    case objectValue:
+      ++stats_->objects;
+      break;
+    }
+  }
+
+  /// Counts an element missing from a sparse array, written as null.
+  void hole() {
+    if (!stats_)
+      return;
+    ++stats_->nodes;
+    ++stats_->literals;
+    stats_->maxDepth = std::max(stats_->maxDepth, depth_ + 1);
+  }
+
+  void memberName(char const* name, char const* end) {
+    if (!stats_)
+      return;
+    ++stats_->memberNames;
+    string(name, end);
+  }
+
+  /// Brackets the children of the container last passed to value().
+  void enter() { ++depth_; }
+  void leave() { --depth_; }
+
+  /*!
+  Counts a tree whose text was spliced from a serialization cache instead of being formatted, with an explicit stack so that deep trees do not exhaust the call stack.
+  */
+  void splicedTree(Value const& root) {
+    if (!stats_)
+      return;
+    size_t const base = depth_;
+    std::vector<std::pair<Value const*, size_t>> pending{{&root, base}};
+    while (!pending.empty()) {
+      Value const& node = *pending.back().first;
+      depth_ = pending.back().second;
+      pending.pop_back();
+      value(node);
+      if (node.isArray()) {
+        for (ArrayIndex index = node.size(); index-- != 0;)
+          pending.emplace_back(&node[index], depth_ + 1);
+      } else if (node.isObject()) {
+        for (auto it = node.begin(); it != node.end(); ++it) {
+          char const* end;
+          char const* name = it.memberName(&end);
+          memberName(name, end);
+          pending.emplace_back(&*it, depth_ + 1);
+        }
+      }
+    }
+    depth_ = base;
+  }
+
+  /// Adds the counters a parallel worker gathered into its own object.
+  void merge(WriteStats const& other) {
+    if (!stats_)
+      return;
+    stats_->objects += other.objects;
+    stats_->arrays += other.arrays;
+    stats_->strings += other.strings;
+    stats_->memberNames += other.memberNames;
+    stats_->integers += other.integers;
+    stats_->reals += other.reals;
+    stats_->literals += other.literals;
+    stats_->escapes += other.escapes;
+    stats_->nodes += other.nodes;
+    stats_->maxDepth = std::max(stats_->maxDepth, other.maxDepth);
+  }
+
+private:
+  void string(char const* str, char const* end) {
+    ++stats_->strings;
+    stats_->escapes +=
+        escapeSequenceCount(str, static_cast<size_t>(end - str), emitUTF8_);
+  }
+
+  WriteStats* stats_;
+  bool emitUTF8_;
+  size_t depth_ = 0;
+  std::streampos startPosition_;
+  Clock::time_point start_;
+};
+} // namespace
+
 /*!
 Converts a C-string to a JSON-compatible quoted string by delegating to valueToQuotedStringN, using the input's length calculated with strlen.
 */
@@ -1042,6 +1226,102 @@ struct CommentStyle {
   enum Enum { None, Most, All };
 };
 
+/*!
+\class BuiltStyle
+\brief Holds the output options read from StreamWriterBuilder settings.
+
+Shared by the writers created from a StreamWriterBuilder so that every one of them interprets the settings identically.
+*/
+struct BuiltStyle {
+  String indentation;
+  CommentStyle::Enum cs;
+  String colonSymbol;
+  String nullSymbol;
+  bool useSpecialFloats;
+  bool emitUTF8;
+  unsigned int precision;
+  PrecisionType precisionType;
+  ArrayIndex parallelThreshold;
+  unsigned int parallelThreads;
+  WriteStats* stats = nullptr;
+};
+
+/*!
+Reads and validates the writer settings, deriving the colon and null symbols from the indentation, YAML compatibility and null placeholder options.
+Throws a RuntimeError when commentStyle or precisionType hold unsupported values.
+*/
+static BuiltStyle parseBuiltStyle(Value const& settings) {
+  BuiltStyle style;
+  style.indentation = settings["indentation"].asString();
+  const String cs_str = settings["commentStyle"].asString();
+  const String pt_str = settings["precisionType"].asString();
+  const bool eyc = settings["enableYAMLCompatibility"].asBool();
+  const bool dnp = settings["dropNullPlaceholders"].asBool();
+  style.useSpecialFloats = settings["useSpecialFloats"].asBool();
+  style.emitUTF8 = settings["emitUTF8"].asBool();
+  unsigned int pre = settings["precision"].asUInt();
+  style.cs = CommentStyle::All;
+  if (cs_str == "All") {
+    style.cs = CommentStyle::All;
+  } else if (cs_str == "None") {
+    style.cs = CommentStyle::None;
+  } else {
+    throwRuntimeError("commentStyle must be 'All' or 'None'");
+  }
+  style.precisionType = PrecisionType::significantDigits;
+  if (pt_str == "significant") {
+    style.precisionType = PrecisionType::significantDigits;
+  } else if (pt_str == "decimal") {
+    style.precisionType = PrecisionType::decimalPlaces;
+  } else {
+    throwRuntimeError("precisionType must be 'significant' or 'decimal'");
+  }
+  style.colonSymbol = " : ";
+  if (eyc) {
+    style.colonSymbol = ": ";
+  } else if (style.indentation.empty()) {
+    style.colonSymbol = ":";
+  }
+  style.nullSymbol = "null";
+  if (dnp) {
+    style.nullSymbol.clear();
+  }
+  if (pre > 17)
+    pre = 17;
+  style.precision = pre;
+  style.parallelThreshold = settings["parallelThreshold"].asUInt();
+  style.parallelThreads = settings["parallelThreads"].asUInt();
+  if (style.parallelThreads == 0)
+    style.parallelThreads = std::thread::hardware_concurrency();
+  return style;
+}
+
+/*!
+Describes every setting that changes the bytes written for a value, so that a fragment cached under one configuration is never spliced into the output of another.
+Strings are length-prefixed to keep distinct settings from producing the same key.
+*/
+static String serializationCacheKey(char writer, String const& indentation,
+                                    CommentStyle::Enum cs,
+                                    String const& colonSymbol,
+                                    String const& nullSymbol,
+                                    bool useSpecialFloats, bool emitUTF8,
+                                    unsigned int precision,
+                                    PrecisionType precisionType) {
+  String key(1, writer);
+  for (String const* symbol : {&indentation, &colonSymbol, &nullSymbol}) {
+    key += valueToString(LargestUInt(symbol->size()));
+    key += ':';
+    key += *symbol;
+  }
+  key += cs == CommentStyle::None ? 'n' : 'a';
+  key += useSpecialFloats ? 's' : '-';
+  key += emitUTF8 ? 'u' : '-';
+  key += precisionType == PrecisionType::decimalPlaces ? 'd' : 'g';
+  key += valueToString(LargestUInt(precision));
+  key += ';';
+  return key;
+}
+
 /*!
 \class BuiltStyledStreamWriter
 \brief Implements a customizable JSON stream writer with styling options.
@@ -1066,12 +1346,18 @@ struct BuiltStyledStreamWriter : public StreamWriter {
   \param emitUTF8 Boolean determining whether to emit UTF-8 encoded output.
   \param precision Unsigned integer specifying the precision for floating-point number output.
   \param precisionType Enum defining the type of precision to apply to floating-point numbers.
+  \param parallelThreshold Minimum number of elements or members for a container to be serialized by several threads, or 0 to always write serially.
+  \param parallelThreads Number of threads sharing the work on a large container.
+  \param stats Counters filled in by every write, or nullptr.
   */
   BuiltStyledStreamWriter(String indentation, CommentStyle::Enum cs,
                           String colonSymbol, String nullSymbol,
                           String endingLineFeedSymbol, bool useSpecialFloats,
                           bool emitUTF8, unsigned int precision,
-                          PrecisionType precisionType);
+                          PrecisionType precisionType,
+                          ArrayIndex parallelThreshold = 0,
+                          unsigned int parallelThreads = 1,
+                          WriteStats* stats = nullptr);
   /*!
   \brief Writes a JSON value to an output stream.
   
@@ -1097,6 +1383,21 @@ private:
   */
   void writeValue(Value const& value);
   /*!
+  \brief Writes a value whose serialization cache is enabled.
+  
+  Splices the fragment stored for the current indentation level and state if there is one; otherwise writes the value into a buffer and stores it before copying it to the output.
+  The state of the writer after the value is stored with the fragment as a trailing character.
+  
+  \param value The JSON value to be written, which must have its serialization cache enabled.
+  */
+  void writeCachedValue(Value const& value);
+  /*!
+  \brief Writes a JSON value without consulting its serialization cache.
+  
+  \param value The JSON value to be serialized.
+  */
+  void writeValuePayload(Value const& value);
+  /*!
   \brief Writes a JSON array value to the output stream.
   
   Formats and writes a JSON array value to the output stream.
@@ -1118,6 +1419,49 @@ private:
   */
   bool isMultilineArray(Value const& value);
   /*!
+  \brief Writes a range of elements of a multi-line array.
+
+  Emits each element with its comments, indentation and trailing separator, exactly as the serial array layout does.
+
+  \param value The JSON array being written.
+  \param begin Index of the first element to write.
+  \param end Index one past the last element to write.
+  */
+  void writeArrayElements(Value const& value, ArrayIndex begin,
+                          ArrayIndex end);
+  /*!
+  \brief Writes a range of members of a non-empty object.
+
+  Emits each member name, its value, comments and trailing separator, exactly as the serial object layout does.
+
+  \param value The JSON object being written.
+  \param begin Iterator to the first member to write.
+  \param end Iterator one past the last member to write.
+  */
+  void writeObjectMembers(Value const& value, Value::const_iterator begin,
+                          Value::const_iterator end);
+  /*!
+  \brief Checks whether a container is large enough to be split across threads.
+
+  \param size Number of elements or members of the container.
+
+  \return True if parallel serialization is enabled, size reaches the threshold, and more than one thread is available.
+  */
+  bool shouldWriteInParallel(size_t size) const;
+  /*!
+  \brief Serializes a container in chunks on several threads.
+
+  Splits the range [0, count) into chunks, lets copies of this writer serialize the chunks concurrently into separate buffers, and appends the buffers to the output stream in order.
+  Every copy starts from the indentation state of this writer, so the result is byte-identical to a serial write.
+
+  \param count Number of elements or members to write.
+  \param writeRange Callback writing the elements [begin, end) with the given writer.
+  */
+  void writeInParallel(
+      size_t count,
+      std::function<void(BuiltStyledStreamWriter&, size_t, size_t)> const&
+          writeRange);
+  /*!
   \brief Writes a JSON value to the output.
   
   Appends the given value either to the internal child values collection or directly to the output stream.
@@ -1203,6 +1547,10 @@ private:
   bool emitUTF8_ : 1;
   unsigned int precision_;
   PrecisionType precisionType_;
+  ArrayIndex parallelThreshold_;
+  unsigned int parallelThreads_;
+  String cacheKey_;
+  WriteStatsRecorder recorder_;
 };
 /*!
 Initializes the writer with custom formatting options, setting up parameters for indentation, comment style, symbol representations, and numeric precision.
@@ -1211,18 +1559,27 @@ Configures internal state variables to control JSON output styling and formattin
 BuiltStyledStreamWriter::BuiltStyledStreamWriter(
     String indentation, CommentStyle::Enum cs, String colonSymbol,
     String nullSymbol, String endingLineFeedSymbol, bool useSpecialFloats,
-    bool emitUTF8, unsigned int precision, PrecisionType precisionType)
+    bool emitUTF8, unsigned int precision, PrecisionType precisionType,
+    ArrayIndex parallelThreshold, unsigned int parallelThreads,
+    WriteStats* stats)
     : rightMargin_(74), indentation_(std::move(indentation)), cs_(cs),
       colonSymbol_(std::move(colonSymbol)), nullSymbol_(std::move(nullSymbol)),
       endingLineFeedSymbol_(std::move(endingLineFeedSymbol)),
       addChildValues_(false), indented_(false),
       useSpecialFloats_(useSpecialFloats), emitUTF8_(emitUTF8),
-      precision_(precision), precisionType_(precisionType) {}
+      precision_(precision), precisionType_(precisionType),
+      parallelThreshold_(parallelThreshold),
+      parallelThreads_(parallelThreads),
+      cacheKey_(serializationCacheKey('b', indentation_, cs_, colonSymbol_,
+                                      nullSymbol_, useSpecialFloats,
+                                      emitUTF8, precision, precisionType)),
+      recorder_(stats, emitUTF8) {}
 /*!
 Formats and writes the given JSON value to the specified output stream, applying configured styling options.
 Manages indentation, comments, and value writing, ensuring proper formatting of the JSON output.
 */
 int BuiltStyledStreamWriter::write(Value const& root, OStream* sout) {
+  recorder_.begin(sout);
   sout_ = sout;
   addChildValues_ = false;
   indented_ = true;
@@ -1234,15 +1591,53 @@ int BuiltStyledStreamWriter::write(Value const& root, OStream* sout) {
   writeValue(root);
   writeCommentAfterValueOnSameLine(root);
   *sout_ << endingLineFeedSymbol_;
+  recorder_.finish(sout);
   sout_ = nullptr;
   return 0;
 }
+/*!
+Writes the JSON value to the output stream, splicing its cached serialization when the value enabled one.
+Values collected for a single-line array are always formatted afresh.
+*/
+void BuiltStyledStreamWriter::writeValue(Value const& value) {
+  if (value.hasSerializationCache() && !addChildValues_)
+    writeCachedValue(value);
+  else
+    writeValuePayload(value);
+}
+
+/*!
+The fragment depends on the indentation level and on whether the line is already indented, so both are part of the key.
+*/
+void BuiltStyledStreamWriter::writeCachedValue(Value const& value) {
+  String key = cacheKey_;
+  key += valueToString(LargestUInt(indentString_.size()));
+  key += indented_ ? '+' : '-';
+  String fragment;
+  if (!value.findCachedSerialization(key, &fragment)) {
+    OStringStream buffer;
+    OStream* const sout = sout_;
+    sout_ = &buffer;
+    writeValuePayload(value);
+    sout_ = sout;
+    fragment = buffer.str();
+    fragment += indented_ ? '+' : '-';
+    value.storeCachedSerialization(key, fragment);
+  } else {
+    recorder_.splicedTree(value);
+  }
+  sout_->write(fragment.data(),
+               static_cast<std::streamsize>(fragment.size() - 1));
+  indented_ = fragment.back() == '+';
+}
+
 /*!
 Writes the JSON value to the output stream based on its type.
 Handles various JSON value types, including null, numeric, string, boolean, array, and object, applying appropriate formatting and styling options.
-For complex types like arrays and objects, it recursively processes their contents, managing indentation and comments as configured.
+For complex types like arrays and objects, it recursively processes their contents through writeValue(), managing indentation and comments as configured.
 */
-void BuiltStyledStreamWriter::writeValue(Value const& value) {
+void BuiltStyledStreamWriter::writeValuePayload(Value const& value) {
+  recorder_.value(value);
   switch (value.type()) {
   case nullValue:
     pushValue(nullSymbol_);
@@ -1272,33 +1667,36 @@ void BuiltStyledStreamWriter::writeValue(Value const& value) {
     pushValue(valueToString(value.asBool()));
     break;
   case arrayValue:
+    recorder_.enter();
     writeArrayValue(value);
+    recorder_.leave();
     break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
+    if (value.empty())
       pushValue("{}");
     else {
+      recorder_.enter();
       writeWithIndent("{");
       indent();
-      auto it = members.begin();
-      for (;;) {
-        String const& name = *it;
-        Value const& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(
-            valueToQuotedStringN(name.data(), name.length(), emitUTF8_));
-        *sout_ << colonSymbol_;
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        *sout_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
+      if (shouldWriteInParallel(value.size())) {
+        std::vector<Value::const_iterator> members;
+        members.reserve(value.size());
+        for (auto it = value.begin(); it != value.end(); ++it)
+          members.push_back(it);
+        writeInParallel(members.size(),
+                        [&value, &members](BuiltStyledStreamWriter& writer,
+                                           size_t begin, size_t end) {
+                          writer.writeObjectMembers(
+                              value, members[begin],
+                              end == members.size() ? value.end()
+                                                    : members[end]);
+                        });
+      } else {
+        writeObjectMembers(value, value.begin(), value.end());
       }
       unindent();
       writeWithIndent("}");
+      recorder_.leave();
     }
   } break;
   }
@@ -1319,25 +1717,27 @@ void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
       writeWithIndent("[");
       indent();
       bool hasChildValue = !childValues_.empty();
-      unsigned index = 0;
-      for (;;) {
-        Value const& childValue = value[index];
-        writeCommentBeforeValue(childValue);
-        if (hasChildValue)
+      if (hasChildValue) {
+        unsigned index = 0;
+        for (;;) {
+          Value const& childValue = value[index];
+          writeCommentBeforeValue(childValue);
           writeWithIndent(childValues_[index]);
-        else {
-          if (!indented_)
-            writeIndent();
-          indented_ = true;
-          writeValue(childValue);
-          indented_ = false;
-        }
-        if (++index == size) {
+          if (++index == size) {
+            writeCommentAfterValueOnSameLine(childValue);
+            break;
+          }
+          *sout_ << ",";
           writeCommentAfterValueOnSameLine(childValue);
-          break;
         }
-        *sout_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
+      } else if (shouldWriteInParallel(size)) {
+        writeInParallel(size, [&value](BuiltStyledStreamWriter& writer,
+                                       size_t begin, size_t end) {
+          writer.writeArrayElements(value, static_cast<ArrayIndex>(begin),
+                                    static_cast<ArrayIndex>(end));
+        });
+      } else {
+        writeArrayElements(value, 0, size);
       }
       unindent();
       writeWithIndent("]");
@@ -1358,6 +1758,127 @@ void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
   }
 }
 
+/*!
+Writes the elements [begin, end) of a multi-line array, each on its own indented line followed by a separator unless it is the last element of the array.
+*/
+void BuiltStyledStreamWriter::writeArrayElements(Value const& value,
+                                                 ArrayIndex begin,
+                                                 ArrayIndex end) {
+  ArrayIndex const size = value.size();
+  for (ArrayIndex index = begin; index < end; ++index) {
+    Value const& childValue = value[index];
+    writeCommentBeforeValue(childValue);
+    if (!indented_)
+      writeIndent();
+    indented_ = true;
+    writeValue(childValue);
+    indented_ = false;
+    if (index + 1 != size)
+      *sout_ << ",";
+    writeCommentAfterValueOnSameLine(childValue);
+  }
+}
+
+/*!
+Writes the members [begin, end) of an object, each as an indented name, colon symbol and value, followed by a separator unless it is the last member.
+Members are visited in map order, which is the order getMemberNames() would return, without copying their names.
+*/
+void BuiltStyledStreamWriter::writeObjectMembers(Value const& value,
+                                                 Value::const_iterator begin,
+                                                 Value::const_iterator end) {
+  for (auto it = begin; it != end;) {
+    Value const& childValue = *it;
+    char const* nameEnd;
+    char const* name = it.memberName(&nameEnd);
+    recorder_.memberName(name, nameEnd);
+    writeCommentBeforeValue(childValue);
+    writeWithIndent(valueToQuotedStringN(
+        name, static_cast<size_t>(nameEnd - name), emitUTF8_));
+    *sout_ << colonSymbol_;
+    writeValue(childValue);
+    if (++it != value.end())
+      *sout_ << ",";
+    writeCommentAfterValueOnSameLine(childValue);
+  }
+}
+
+bool BuiltStyledStreamWriter::shouldWriteInParallel(size_t size) const {
+  return parallelThreshold_ != 0 && size >= parallelThreshold_ &&
+         parallelThreads_ > 1 && !addChildValues_;
+}
+
+/*!
+Distributes chunks of the container over worker threads that each own a copy of this writer and a private buffer.
+Nested containers are written serially by the workers, and the buffers are appended to the output in their original order once every worker has finished.
+Each worker counts into its own WriteStats, which are added to the counters of this writer after the join.
+*/
+void BuiltStyledStreamWriter::writeInParallel(
+    size_t count,
+    std::function<void(BuiltStyledStreamWriter&, size_t, size_t)> const&
+        writeRange) {
+  size_t const chunkCount =
+      std::min(count, static_cast<size_t>(parallelThreads_) * 4);
+  size_t const chunkSize = (count + chunkCount - 1) / chunkCount;
+  std::vector<OStringStream> buffers(chunkCount);
+#if JSON_USE_EXCEPTION
+  std::vector<std::exception_ptr> errors(chunkCount);
+#endif
+  size_t const threadCount =
+      std::min(static_cast<size_t>(parallelThreads_), chunkCount);
+  std::vector<WriteStats> workerStats(recorder_.stats() ? threadCount : 0);
+  std::atomic<size_t> nextChunk(0);
+  auto work = [&](size_t thread) {
+    BuiltStyledStreamWriter worker(*this);
+    worker.parallelThreshold_ = 0;
+    worker.childValues_.clear();
+    if (!workerStats.empty())
+      worker.recorder_.redirect(&workerStats[thread]);
+    for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+      worker.sout_ = &buffers[chunk];
+      worker.indented_ = indented_;
+      size_t const begin = chunk * chunkSize;
+      size_t const end = std::min(count, begin + chunkSize);
+#if JSON_USE_EXCEPTION
+      try {
+        writeRange(worker, begin, end);
+      } catch (...) {
+        errors[chunk] = std::current_exception();
+      }
+#else
+      writeRange(worker, begin, end);
+#endif
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount - 1);
+#if JSON_USE_EXCEPTION
+  // Chunks are claimed on demand, so when no more threads can be started
+  // the ones already running and this thread share the remaining work.
+  try {
+    for (size_t i = 1; i < threadCount; ++i)
+      threads.emplace_back(work, i);
+  } catch (std::system_error const&) {
+  }
+#else
+  for (size_t i = 1; i < threadCount; ++i)
+    threads.emplace_back(work, i);
+#endif
+  work(0);
+  for (auto& thread : threads)
+    thread.join();
+  for (auto const& stats : workerStats)
+    recorder_.merge(stats);
+#if JSON_USE_EXCEPTION
+  for (auto const& error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+#endif
+  for (auto const& buffer : buffers)
+    *sout_ << buffer.str();
+  indented_ = false;
+}
+
 /*!
 Analyzes a JSON array to determine if it should be written across multiple lines.
 Considers array size, content complexity, and presence of comments, calculating the potential line length and comparing it against the right margin to make the decision.
@@ -1485,6 +2006,325 @@ bool BuiltStyledStreamWriter::hasCommentForValue(const Value& value) {
          value.hasComment(commentAfter);
 }
 
+/*!
+\class CompactStreamWriter
+\brief Writes JSON without indentation, with every style decision made at compile time.
+
+Produces exactly the output of BuiltStyledStreamWriter with an empty indentation, but the comment style, UTF-8 emission, special float and precision type options are template parameters, so the per-token code has no style branches.
+Numbers, strings and member names are formatted into stack buffers or written straight to the stream, so no String is allocated per token.
+*/
+template <bool WithComments, bool EmitUTF8, bool UseSpecialFloats,
+          PrecisionType Precision>
+struct CompactStreamWriter : public StreamWriter {
+  /*!
+  \brief Initializes the writer from parsed builder settings.
+
+  \param style The settings the writer was selected for; only the symbols and the precision are read at run time.
+  */
+  explicit CompactStreamWriter(BuiltStyle const& style)
+      : colonSymbol_(style.colonSymbol), nullSymbol_(style.nullSymbol),
+        precision_(style.precision),
+        cacheKey_(serializationCacheKey(
+            'c', style.indentation, style.cs, style.colonSymbol,
+            style.nullSymbol, style.useSpecialFloats, style.emitUTF8,
+            style.precision, style.precisionType)),
+        recorder_(style.stats, EmitUTF8) {}
+
+  int write(Value const& root, OStream* sout) override {
+    recorder_.begin(sout);
+    sout_ = sout;
+    writeCommentBeforeValue(root);
+    writeValue(root);
+    writeCommentAfterValue(root);
+    recorder_.finish(sout);
+    sout_ = nullptr;
+    return 0;
+  }
+
+private:
+  void writeRaw(char const* text, size_t length) {
+    sout_->write(text, static_cast<std::streamsize>(length));
+  }
+
+  void writeValue(Value const& value) {
+    if (value.hasSerializationCache())
+      writeCachedValue(value);
+    else
+      writeValuePayload(value);
+  }
+
+  /*!
+  Splices the stored fragment, or writes the value into a buffer and stores it first; compact output does not depend on where the value appears.
+  */
+  void writeCachedValue(Value const& value) {
+    String fragment;
+    if (!value.findCachedSerialization(cacheKey_, &fragment)) {
+      OStringStream buffer;
+      OStream* const sout = sout_;
+      sout_ = &buffer;
+      writeValuePayload(value);
+      sout_ = sout;
+      fragment = buffer.str();
+      value.storeCachedSerialization(cacheKey_, fragment);
+    } else {
+      recorder_.splicedTree(value);
+    }
+    writeRaw(fragment.data(), fragment.size());
+  }
+
+  void writeValuePayload(Value const& value) {
+    recorder_.value(value);
+    switch (value.type()) {
+    case nullValue:
+      writeRaw(nullSymbol_.data(), nullSymbol_.size());
+      break;
+    case intValue:
+      writeInteger(value.asLargestInt());
+      break;
+    case uintValue:
+      writeUnsigned(value.asLargestUInt());
+      break;
+    case realValue:
+      writeReal(value.asDouble());
+      break;
+    case stringValue: {
+      char const* str;
+      char const* end;
+      if (value.getString(&str, &end))
+        writeQuoted(str, static_cast<size_t>(end - str));
+      break;
+    }
+    case booleanValue:
+      if (value.asBool())
+        writeRaw("true", 4);
+      else
+        writeRaw("false", 5);
+      break;
+    case arrayValue:
+      recorder_.enter();
+      writeArrayValue(value);
+      recorder_.leave();
+      break;
+    case objectValue:
+      recorder_.enter();
+      writeObjectValue(value);
+      recorder_.leave();
+      break;
+    }
+  }
+
+  /*!
+  Walks the array map once; indices missing from a sparse array are written as the null symbol, as the indexed lookup of BuiltStyledStreamWriter would.
+  */
+  void writeArrayValue(Value const& value) {
+    ArrayIndex const size = value.size();
+    sout_->put('[');
+    ArrayIndex index = 0;
+    for (auto it = value.begin(); it != value.end(); ++it) {
+      for (; index < it.index(); ++index) {
+        recorder_.hole();
+        writeRaw(nullSymbol_.data(), nullSymbol_.size());
+        sout_->put(',');
+      }
+      writeCommentBeforeValue(*it);
+      writeValue(*it);
+      if (++index != size)
+        sout_->put(',');
+      writeCommentAfterValue(*it);
+    }
+    sout_->put(']');
+  }
+
+  void writeObjectValue(Value const& value) {
+    sout_->put('{');
+    for (auto it = value.begin(); it != value.end();) {
+      Value const& childValue = *it;
+      char const* nameEnd;
+      char const* name = it.memberName(&nameEnd);
+      recorder_.memberName(name, nameEnd);
+      writeCommentBeforeValue(childValue);
+      writeQuoted(name, static_cast<size_t>(nameEnd - name));
+      writeRaw(colonSymbol_.data(), colonSymbol_.size());
+      writeValue(childValue);
+      if (++it != value.end())
+        sout_->put(',');
+      writeCommentAfterValue(childValue);
+    }
+    sout_->put('}');
+  }
+
+  void writeUnsigned(LargestUInt value) {
+    UIntToStringBuffer buffer;
+    char* current = buffer + sizeof(buffer);
+    uintToString(value, current);
+    writeRaw(current, static_cast<size_t>(buffer + sizeof(buffer) - 1 - current));
+  }
+
+  void writeInteger(LargestInt value) {
+    UIntToStringBuffer buffer;
+    char* current = buffer + sizeof(buffer);
+    if (value == Value::minLargestInt) {
+      uintToString(LargestUInt(Value::maxLargestInt) + 1, current);
+      *--current = '-';
+    } else if (value < 0) {
+      uintToString(LargestUInt(-value), current);
+      *--current = '-';
+    } else {
+      uintToString(LargestUInt(value), current);
+    }
+    writeRaw(current, static_cast<size_t>(buffer + sizeof(buffer) - 1 - current));
+  }
+
+  /*!
+  Formats into a stack buffer with the same steps as valueToString(); only decimal precision on huge magnitudes, which does not fit the buffer, falls back to it.
+  */
+  void writeReal(double value) {
+    if (!isfinite(value)) {
+      char const* text = UseSpecialFloats
+                             ? (isnan(value) ? "NaN"
+                                : value < 0  ? "-Infinity"
+                                             : "Infinity")
+                             : (isnan(value) ? "null"
+                                : value < 0  ? "-1e+9999"
+                                             : "1e+9999");
+      writeRaw(text, strlen(text));
+      return;
+    }
+    char buffer[64];
+    int const len = jsoncpp_snprintf(
+        buffer, sizeof(buffer) - 2,
+        Precision == PrecisionType::significantDigits ? "%.*g" : "%.*f",
+        precision_, value);
+    assert(len >= 0);
+    auto length = static_cast<size_t>(len);
+    if (length >= sizeof(buffer) - 2) {
+      String const text =
+          valueToString(value, UseSpecialFloats, precision_, Precision);
+      writeRaw(text.data(), text.size());
+      return;
+    }
+    char* end = fixNumericLocale(buffer, buffer + length);
+    if (std::find(buffer, end, '.') == end && std::find(buffer, end, 'e') == end) {
+      *end++ = '.';
+      *end++ = '0';
+    }
+    if (Precision == PrecisionType::decimalPlaces)
+      end = fixZerosInTheEnd(buffer, end, precision_);
+    writeRaw(buffer, static_cast<size_t>(end - buffer));
+  }
+
+  void writeHex(unsigned int codepoint) {
+    char escape[6] = {'\\', 'u', 0, 0, 0, 0};
+    unsigned int const hi = (codepoint >> 8) & 0xff;
+    unsigned int const lo = codepoint & 0xff;
+    escape[2] = hex2[2 * hi];
+    escape[3] = hex2[2 * hi + 1];
+    escape[4] = hex2[2 * lo];
+    escape[5] = hex2[2 * lo + 1];
+    writeRaw(escape, sizeof(escape));
+  }
+
+  /*!
+  Writes runs of characters that need no escaping straight from the source, and the escape sequences of valueToQuotedStringN() between them.
+  */
+  void writeQuoted(char const* value, size_t length) {
+    if (value == nullptr)
+      return;
+    sout_->put('"');
+    char const* const end = value + length;
+    char const* run = value;
+    for (char const* c = value; c != end; ++c) {
+      auto const ch = static_cast<unsigned char>(*c);
+      if (ch >= 0x20 && ch != '"' && ch != '\\' && (EmitUTF8 || ch < 0x80))
+        continue;
+      writeRaw(run, static_cast<size_t>(c - run));
+      switch (ch) {
+      case '"':
+        writeRaw("\\\"", 2);
+        break;
+      case '\\':
+        writeRaw("\\\\", 2);
+        break;
+      case '\b':
+        writeRaw("\\b", 2);
+        break;
+      case '\f':
+        writeRaw("\\f", 2);
+        break;
+      case '\n':
+        writeRaw("\\n", 2);
+        break;
+      case '\r':
+        writeRaw("\\r", 2);
+        break;
+      case '\t':
+        writeRaw("\\t", 2);
+        break;
+      default: {
+        unsigned codepoint = EmitUTF8 ? ch : utf8ToCodepoint(c, end);
+        if (codepoint < 0x10000) {
+          writeHex(codepoint);
+        } else {
+          codepoint -= 0x10000;
+          writeHex(0xd800 + ((codepoint >> 10) & 0x3ff));
+          writeHex(0xdc00 + (codepoint & 0x3ff));
+        }
+      } break;
+      }
+      run = c + 1;
+    }
+    writeRaw(run, static_cast<size_t>(end - run));
+    sout_->put('"');
+  }
+
+  void writeCommentBeforeValue(Value const& value) {
+    if (!WithComments || !value.hasComment(commentBefore))
+      return;
+    String const comment = value.getComment(commentBefore);
+    writeRaw(comment.data(), comment.size());
+  }
+
+  void writeCommentAfterValue(Value const& value) {
+    if (!WithComments)
+      return;
+    if (value.hasComment(commentAfterOnSameLine)) {
+      String const comment = value.getComment(commentAfterOnSameLine);
+      sout_->put(' ');
+      writeRaw(comment.data(), comment.size());
+    }
+    if (value.hasComment(commentAfter)) {
+      String const comment = value.getComment(commentAfter);
+      writeRaw(comment.data(), comment.size());
+    }
+  }
+
+  String colonSymbol_;
+  String nullSymbol_;
+  unsigned int precision_;
+  String cacheKey_;
+  WriteStatsRecorder recorder_;
+};
+
+/*!
+Instantiates the CompactStreamWriter matching the run-time comment style and precision type, once the other options are fixed by the caller.
+*/
+template <bool EmitUTF8, bool UseSpecialFloats>
+static StreamWriter* newCompactStreamWriter(BuiltStyle const& style) {
+  bool const withComments = style.cs != CommentStyle::None;
+  if (style.precisionType == PrecisionType::decimalPlaces) {
+    if (withComments)
+      return new CompactStreamWriter<true, EmitUTF8, UseSpecialFloats,
+                                     PrecisionType::decimalPlaces>(style);
+    return new CompactStreamWriter<false, EmitUTF8, UseSpecialFloats,
+                                   PrecisionType::decimalPlaces>(style);
+  }
+  if (withComments)
+    return new CompactStreamWriter<true, EmitUTF8, UseSpecialFloats,
+                                   PrecisionType::significantDigits>(style);
+  return new CompactStreamWriter<false, EmitUTF8, UseSpecialFloats,
+                                 PrecisionType::significantDigits>(style);
+}
+
 /*!
 Initializes the StreamWriter object with a null output stream pointer, setting up the base for JSON writing operations.
 */
@@ -1499,50 +2339,33 @@ StreamWriterBuilder::StreamWriterBuilder() { setDefaults(&settings_); }
 StreamWriterBuilder::~StreamWriterBuilder() = default;
 /*!
 Creates a new StreamWriter instance based on the current settings.
-Configures various formatting options such as indentation, comment style, precision, and UTF-8 encoding.
+Compact output (empty indentation) is handled by a CompactStreamWriter specialized for the remaining options; everything else uses the BuiltStyledStreamWriter.
+The indented layout stays configured at run time: its time goes to the Strings it builds per token, partly to measure short arrays before choosing a layout, and to indexed element lookups, none of which templating on the options would remove.
 Returns a pointer to the newly created StreamWriter object.
 */
 StreamWriter* StreamWriterBuilder::newStreamWriter() const {
-  const String indentation = settings_["indentation"].asString();
-  const String cs_str = settings_["commentStyle"].asString();
-  const String pt_str = settings_["precisionType"].asString();
-  const bool eyc = settings_["enableYAMLCompatibility"].asBool();
-  const bool dnp = settings_["dropNullPlaceholders"].asBool();
-  const bool usf = settings_["useSpecialFloats"].asBool();
-  const bool emitUTF8 = settings_["emitUTF8"].asBool();
-  unsigned int pre = settings_["precision"].asUInt();
-  CommentStyle::Enum cs = CommentStyle::All;
-  if (cs_str == "All") {
-    cs = CommentStyle::All;
-  } else if (cs_str == "None") {
-    cs = CommentStyle::None;
-  } else {
-    throwRuntimeError("commentStyle must be 'All' or 'None'");
-  }
-  PrecisionType precisionType(significantDigits);
-  if (pt_str == "significant") {
-    precisionType = PrecisionType::significantDigits;
-  } else if (pt_str == "decimal") {
-    precisionType = PrecisionType::decimalPlaces;
-  } else {
-    throwRuntimeError("precisionType must be 'significant' or 'decimal'");
-  }
-  String colonSymbol = " : ";
-  if (eyc) {
-    colonSymbol = ": ";
-  } else if (indentation.empty()) {
-    colonSymbol = ":";
-  }
-  String nullSymbol = "null";
-  if (dnp) {
-    nullSymbol.clear();
+  return newStreamWriter(nullptr);
+}
+
+/*!
+Hands stats to the writer selected for the settings, which counts into it while it writes.
+*/
+StreamWriter* StreamWriterBuilder::newStreamWriter(WriteStats* stats) const {
+  BuiltStyle style(parseBuiltStyle(settings_));
+  style.stats = stats;
+  if (style.indentation.empty() && style.parallelThreshold == 0) {
+    if (style.emitUTF8)
+      return style.useSpecialFloats ? newCompactStreamWriter<true, true>(style)
+                                    : newCompactStreamWriter<true, false>(style);
+    return style.useSpecialFloats ? newCompactStreamWriter<false, true>(style)
+                                  : newCompactStreamWriter<false, false>(style);
   }
-  if (pre > 17)
-    pre = 17;
   String endingLineFeedSymbol;
-  return new BuiltStyledStreamWriter(indentation, cs, colonSymbol, nullSymbol,
-                                     endingLineFeedSymbol, usf, emitUTF8, pre,
-                                     precisionType);
+  return new BuiltStyledStreamWriter(
+      style.indentation, style.cs, style.colonSymbol, style.nullSymbol,
+      endingLineFeedSymbol, style.useSpecialFloats, style.emitUTF8,
+      style.precision, style.precisionType, style.parallelThreshold,
+      style.parallelThreads, style.stats);
 }
 
 /*!
@@ -1559,6 +2382,8 @@ bool StreamWriterBuilder::validate(Json::Value* invalid) const {
       "emitUTF8",
       "precision",
       "precisionType",
+      "parallelThreshold",
+      "parallelThreads",
   };
   for (auto si = settings_.begin(); si != settings_.end(); ++si) {
     auto key = si.name();
@@ -1588,17 +2413,524 @@ void StreamWriterBuilder::setDefaults(Json::Value* settings) {
   (*settings)["emitUTF8"] = false;
   (*settings)["precision"] = 17;
   (*settings)["precisionType"] = "significant";
+  (*settings)["parallelThreshold"] = 0;
+  (*settings)["parallelThreads"] = 0;
+}
+
+/*!
+Counts the decimal digits of an unsigned integer without formatting it.
+*/
+static size_t uintLength(LargestUInt value) {
+  size_t length = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++length;
+  }
+  return length;
+}
+
+/*!
+Bounds the length valueToString() can produce for a real value: significant precision never exceeds sign, digits, point and a three digit exponent, while decimal precision depends on the magnitude of the integral part.
+*/
+static size_t realLengthBound(double value, unsigned int precision,
+                              PrecisionType precisionType) {
+  size_t const digits = precision == 0 ? 1 : precision;
+  if (precisionType == PrecisionType::significantDigits || !isfinite(value))
+    return digits + 8;
+  double const magnitude = std::fabs(value);
+  size_t integralDigits = 1;
+  if (magnitude >= 1)
+    integralDigits = static_cast<size_t>(std::log10(magnitude)) + 2;
+  return 1 + integralDigits + 1 + precision + 2;
 }
 
+/*!
+Computes the exact length of the quoted and escaped form of a string, mirroring the escaping rules of valueToQuotedStringN.
+*/
+static size_t quotedStringLength(char const* value, size_t length,
+                                 bool emitUTF8) {
+  if (value == nullptr)
+    return 0;
+  size_t result = 2;
+  char const* end = value + length;
+  for (char const* c = value; c != end; ++c) {
+    switch (*c) {
+    case '\"':
+    case '\\':
+    case '\b':
+    case '\f':
+    case '\n':
+    case '\r':
+    case '\t':
+      result += 2;
+      break;
+    default: {
+      unsigned codepoint = static_cast<unsigned char>(*c);
+      if (!emitUTF8)
+        codepoint = utf8ToCodepoint(c, end);
+      if (codepoint < 0x20)
+        result += 6;
+      else if (codepoint < 0x80 || emitUTF8)
+        result += 1;
+      else if (codepoint < 0x10000)
+        result += 6;
+      else
+        result += 12;
+    } break;
+    }
+  }
+  return result;
+}
+
+namespace {
+/*!
+\class SizeHintCounter
+\brief Accumulates the serialized length of a value tree for serializedSizeHint().
+
+Follows the layout of BuiltStyledStreamWriter, counting a line break and the full indentation wherever the writer may emit one.
+*/
+struct SizeHintCounter {
+  explicit SizeHintCounter(BuiltStyle const& style) : style_(style) {}
+
+  size_t indentLength(size_t depth) const {
+    if (style_.indentation.empty())
+      return 0;
+    return 1 + depth * style_.indentation.size();
+  }
+
+  size_t commentBeforeLength(Value const& value, size_t depth) const {
+    if (style_.cs == CommentStyle::None || !value.hasComment(commentBefore))
+      return 0;
+    String const comment = value.getComment(commentBefore);
+    size_t length = indentLength(depth) + comment.size();
+    for (size_t i = 0; i + 1 < comment.size(); ++i) {
+      if (comment[i] == '\n' && comment[i + 1] == '/')
+        length += depth * style_.indentation.size();
+    }
+    return length;
+  }
+
+  size_t commentAfterLength(Value const& value, size_t depth) const {
+    if (style_.cs == CommentStyle::None)
+      return 0;
+    size_t length = 0;
+    if (value.hasComment(commentAfterOnSameLine))
+      length += 1 + value.getComment(commentAfterOnSameLine).size();
+    if (value.hasComment(commentAfter))
+      length += indentLength(depth) + value.getComment(commentAfter).size();
+    return length;
+  }
+
+  size_t valueLength(Value const& value, size_t depth) const {
+    switch (value.type()) {
+    case nullValue:
+      return style_.nullSymbol.size();
+    case intValue: {
+      LargestInt const number = value.asLargestInt();
+      if (number < 0)
+        return 1 + uintLength(LargestUInt(0) - LargestUInt(number));
+      return uintLength(LargestUInt(number));
+    }
+    case uintValue:
+      return uintLength(value.asLargestUInt());
+    case realValue:
+      return realLengthBound(value.asDouble(), style_.precision,
+                             style_.precisionType);
+    case stringValue: {
+      char const* str;
+      char const* end;
+      if (!value.getString(&str, &end))
+        return 0;
+      return quotedStringLength(str, static_cast<size_t>(end - str),
+                                style_.emitUTF8);
+    }
+    case booleanValue:
+      return value.asBool() ? 4 : 5;
+    case arrayValue: {
+      ArrayIndex const size = value.size();
+      if (size == 0)
+        return 2;
+      size_t length = 2 * (indentLength(depth) + 1) + (size - 1) +
+                      size * indentLength(depth + 1);
+      ArrayIndex present = 0;
+      for (auto it = value.begin(); it != value.end(); ++it, ++present) {
+        length += commentBeforeLength(*it, depth + 1) +
+                  valueLength(*it, depth + 1) +
+                  commentAfterLength(*it, depth + 1);
+      }
+      return length + (size - present) * style_.nullSymbol.size();
+    }
+    case objectValue: {
+      if (value.empty())
+        return 2;
+      size_t length =
+          2 * (indentLength(depth) + 1) + (value.size() - 1) +
+          value.size() * (indentLength(depth + 1) + style_.colonSymbol.size());
+      for (auto it = value.begin(); it != value.end(); ++it) {
+        char const* end;
+        char const* name = it.memberName(&end);
+        length += commentBeforeLength(*it, depth + 1) +
+                  quotedStringLength(name, static_cast<size_t>(end - name),
+                                     style_.emitUTF8) +
+                  valueLength(*it, depth + 1) +
+                  commentAfterLength(*it, depth + 1);
+      }
+      return length;
+    }
+    }
+    return 0;
+  }
+
+  BuiltStyle const& style_;
+};
+} // namespace
+
+/*!
+Measures the root value the way BuiltStyledStreamWriter::write() lays it out, including the comments attached to the root itself.
+*/
+size_t serializedSizeHint(Value const& root,
+                          StreamWriterBuilder const& builder) {
+  BuiltStyle const style(parseBuiltStyle(builder.settings_));
+  SizeHintCounter const counter(style);
+  size_t length = counter.valueLength(root, 0);
+  if (style.cs != CommentStyle::None && root.hasComment(commentBefore))
+    length += counter.commentBeforeLength(root, 0) + counter.indentLength(0);
+  return length + counter.commentAfterLength(root, 0);
+}
+
+#if !defined(NDEBUG)
+#define JSON_STREAMING_CHECK(condition, message)                               \
+  JSON_ASSERT_MESSAGE(condition, message)
+#else
+#define JSON_STREAMING_CHECK(condition, message)                               \
+  do {                                                                         \
+  } while (0)
+#endif
+
+/*!
+Reads the formatting options from the builder settings and prepares to write a single root value.
+*/
+StreamingWriter::StreamingWriter(StreamWriterBuilder const& builder,
+                                 OStream* sout)
+    : sout_(sout), indented_(true), keyWritten_(false), complete_(false) {
+  BuiltStyle const style(parseBuiltStyle(builder.settings_));
+  indentation_ = style.indentation;
+  colonSymbol_ = style.colonSymbol;
+  nullSymbol_ = style.nullSymbol;
+  precision_ = style.precision;
+  precisionType_ = style.precisionType;
+  useSpecialFloats_ = style.useSpecialFloats;
+  emitUTF8_ = style.emitUTF8;
+}
+
+StreamingWriter::~StreamingWriter() = default;
+
+/*!
+Starts a new object; the opening brace is written lazily so that empty objects come out as "{}".
+*/
+StreamingWriter& StreamingWriter::beginObject() {
+  beginContainer(true);
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::endObject() {
+  endContainer(true);
+  return *this;
+}
+
+/*!
+Starts a new array; the opening bracket is written lazily so that empty arrays come out as "[]".
+*/
+StreamingWriter& StreamingWriter::beginArray() {
+  beginContainer(false);
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::endArray() {
+  endContainer(false);
+  return *this;
+}
+
+/*!
+Writes the separator, the indented quoted member name and the colon symbol, leaving the writer waiting for the member value.
+*/
+StreamingWriter& StreamingWriter::key(char const* begin, char const* end) {
+  JSON_STREAMING_CHECK(!frames_.empty() && frames_.back().isObject,
+                       "StreamingWriter::key() requires an open object");
+  JSON_STREAMING_CHECK(!keyWritten_,
+                       "StreamingWriter::key() called twice without a value");
+  Frame& frame = frames_.back();
+  openContainer(frame);
+  if (frame.count > 0)
+    *sout_ << ",";
+  String const name =
+      valueToQuotedStringN(begin, static_cast<size_t>(end - begin), emitUTF8_);
+  writeWithIndent(name.data(), name.size());
+  *sout_ << colonSymbol_;
+  keyWritten_ = true;
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::key(char const* name) {
+  return key(name, name + strlen(name));
+}
+
+StreamingWriter& StreamingWriter::key(String const& name) {
+  return key(name.data(), name.data() + name.length());
+}
+
+StreamingWriter& StreamingWriter::value(Int value) {
+  writeScalar(valueToString(LargestInt(value)));
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::value(UInt value) {
+  writeScalar(valueToString(LargestUInt(value)));
+  return *this;
+}
+
+#if defined(JSON_HAS_INT64)
+StreamingWriter& StreamingWriter::value(Int64 value) {
+  writeScalar(valueToString(LargestInt(value)));
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::value(UInt64 value) {
+  writeScalar(valueToString(LargestUInt(value)));
+  return *this;
+}
+#endif
+
+StreamingWriter& StreamingWriter::value(double value) {
+  writeScalar(
+      valueToString(value, useSpecialFloats_, precision_, precisionType_));
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::value(bool value) {
+  writeScalar(valueToString(value));
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::value(char const* begin, char const* end) {
+  writeScalar(valueToQuotedStringN(begin, static_cast<size_t>(end - begin),
+                                   emitUTF8_));
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::value(char const* value) {
+  return this->value(value, value + strlen(value));
+}
+
+StreamingWriter& StreamingWriter::value(String const& value) {
+  return this->value(value.data(), value.data() + value.length());
+}
+
+/*!
+Replays the tree through the streaming calls, so that a prebuilt fragment is laid out exactly like streamed content.
+*/
+StreamingWriter& StreamingWriter::value(Value const& value) {
+  switch (value.type()) {
+  case nullValue:
+    null();
+    break;
+  case intValue:
+    this->value(value.asLargestInt());
+    break;
+  case uintValue:
+    this->value(value.asLargestUInt());
+    break;
+  case realValue:
+    this->value(value.asDouble());
+    break;
+  case stringValue: {
+    char const* str;
+    char const* end;
+    if (value.getString(&str, &end))
+      this->value(str, end);
+    else
+      writeScalar(String());
+    break;
+  }
+  case booleanValue:
+    this->value(value.asBool());
+    break;
+  case arrayValue:
+    beginArray();
+    for (ArrayIndex index = 0; index < value.size(); ++index)
+      this->value(value[index]);
+    endArray();
+    break;
+  case objectValue:
+    beginObject();
+    for (auto it = value.begin(); it != value.end(); ++it) {
+      char const* end;
+      char const* name = it.memberName(&end);
+      key(name, end).value(*it);
+    }
+    endObject();
+    break;
+  }
+  return *this;
+}
+
+StreamingWriter& StreamingWriter::null() {
+  writeScalar(nullSymbol_);
+  return *this;
+}
+
+bool StreamingWriter::isComplete() const { return complete_; }
+
+/*!
+Writes whatever precedes a value at the current position: the element separator and indentation inside arrays, nothing after a key or at the root.
+*/
+void StreamingWriter::beginValue() {
+  JSON_STREAMING_CHECK(!complete_,
+                       "StreamingWriter: the root value is already complete");
+  if (frames_.empty())
+    return;
+  Frame& frame = frames_.back();
+  if (frame.isObject) {
+    JSON_STREAMING_CHECK(keyWritten_,
+                         "StreamingWriter: object members require a key()");
+    return;
+  }
+  openContainer(frame);
+  if (frame.count > 0)
+    *sout_ << ",";
+  if (!indented_)
+    writeIndent();
+  indented_ = true;
+}
+
+/*!
+Records that a value has been completed in the enclosing container, or that the document is complete when it was the root.
+*/
+void StreamingWriter::endValue() {
+  if (frames_.empty()) {
+    complete_ = true;
+    return;
+  }
+  Frame& frame = frames_.back();
+  ++frame.count;
+  if (frame.isObject)
+    keyWritten_ = false;
+  else
+    indented_ = false;
+}
+
+void StreamingWriter::beginContainer(bool isObject) {
+  beginValue();
+  keyWritten_ = false;
+  Frame frame;
+  frame.isObject = isObject;
+  frame.opened = false;
+  frame.count = 0;
+  frames_.push_back(frame);
+}
+
+/*!
+Closes the innermost container, emitting "{}" or "[]" when it never received any member.
+*/
+void StreamingWriter::endContainer(bool isObject) {
+  JSON_STREAMING_CHECK(!frames_.empty() && frames_.back().isObject == isObject,
+                       "StreamingWriter: mismatched end of "
+                           << (isObject ? "object" : "array"));
+  JSON_STREAMING_CHECK(!keyWritten_,
+                       "StreamingWriter: missing value after key()");
+  if (frames_.back().opened) {
+    indentString_.resize(indentString_.size() - indentation_.size());
+    if (isObject)
+      writeWithIndent("}", 1);
+    else
+      writeWithIndent("]", 1);
+  } else {
+    *sout_ << (isObject ? "{}" : "[]");
+  }
+  frames_.pop_back();
+  endValue();
+}
+
+/*!
+Writes the deferred opening brace or bracket of a container that is about to receive its first member.
+*/
+void StreamingWriter::openContainer(Frame& frame) {
+  if (frame.opened)
+    return;
+  frame.opened = true;
+  if (frame.isObject)
+    writeWithIndent("{", 1);
+  else
+    writeWithIndent("[", 1);
+  indentString_ += indentation_;
+}
+
+void StreamingWriter::writeScalar(String const& text) {
+  beginValue();
+  *sout_ << text;
+  endValue();
+}
+
+void StreamingWriter::writeIndent() {
+  if (!indentation_.empty()) {
+    *sout_ << '\n' << indentString_;
+  }
+}
+
+void StreamingWriter::writeWithIndent(char const* text, size_t length) {
+  if (!indented_)
+    writeIndent();
+  sout_->write(text, static_cast<std::streamsize>(length));
+  indented_ = false;
+}
+
+namespace {
+/*!
+\class StringAppendBuffer
+\brief Stream buffer appending everything written to it to a String.
+
+Lets writeString() write into a string whose capacity was reserved up front, instead of growing an OStringStream buffer step by step and copying it out at the end.
+*/
+class StringAppendBuffer : public std::streambuf {
+public:
+  explicit StringAppendBuffer(String& target) : target_(target) {}
+
+protected:
+  int_type overflow(int_type ch) override {
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+      target_.push_back(traits_type::to_char_type(ch));
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(char const* s, std::streamsize n) override {
+    target_.append(s, static_cast<size_t>(n));
+    return n;
+  }
+
+  // Only reports the put position, which is what tellp() asks for.
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override {
+    if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out))
+      return pos_type(off_type(-1));
+    return pos_type(static_cast<off_type>(target_.size()));
+  }
+
+private:
+  String& target_;
+};
+} // namespace
+
 /*!
 Serializes a JSON value to a string using a custom stream writer created by the provided factory.
-Writes the JSON value to an output string stream and returns the resulting string.
+Lets the writer append directly to the resulting string, so the text is not copied out of a string stream afterwards.
 */
 String writeString(StreamWriter::Factory const& factory, Value const& root) {
-  OStringStream sout;
+  String result;
+  StringAppendBuffer buffer(result);
+  OStream sout(&buffer);
   StreamWriterPtr const writer(factory.newStreamWriter());
   writer->write(root, &sout);
-  return std::move(sout).str();
+  return result;
 }
 
 OStream& operator<<(OStream& sout, Value const& root) {
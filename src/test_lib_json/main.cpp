@@ -25,6 +25,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 using CharReaderPtr = std::unique_ptr<Json::CharReader>;
@@ -2790,6 +2791,1630 @@ JSONTEST_FIXTURE_LOCAL(StreamWriterTest, escapeTabCharacterWindows) {
 }
 #endif
 
+struct StreamingWriterTest : JsonTest::TestCase {
+  static Json::Value sampleDocument() {
+    Json::Value root;
+    root["count"] = 2;
+    root["empty"] = Json::objectValue;
+    root["items"][0] = "a\tb";
+    root["items"][1] = Json::arrayValue;
+    root["items"][2]["nested"] = true;
+    root["items"][3] = Json::nullValue;
+    root["items"][4] = Json::objectValue;
+    root["real"] = 0.1;
+    root["unicode"] = "\xe2\x82\xac";
+    return root;
+  }
+
+  static void streamSampleDocument(Json::StreamingWriter& writer) {
+    writer.beginObject();
+    writer.key("count").value(2);
+    writer.key("empty").beginObject().endObject();
+    writer.key("items").beginArray();
+    writer.value("a\tb");
+    writer.beginArray().endArray();
+    writer.beginObject().key("nested").value(true).endObject();
+    writer.null();
+    writer.beginObject().endObject();
+    writer.endArray();
+    writer.key(Json::String("real")).value(0.1);
+    writer.key("unicode").value(Json::String("\xe2\x82\xac"));
+    writer.endObject();
+  }
+
+  void checkMatchesBuilder(Json::StreamWriterBuilder const& builder) {
+    Json::OStringStream sout;
+    Json::StreamingWriter writer(builder, &sout);
+    streamSampleDocument(writer);
+    JSONTEST_ASSERT(writer.isComplete());
+    JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(builder, sampleDocument()),
+                                 sout.str());
+  }
+};
+
+JSONTEST_FIXTURE_LOCAL(StreamingWriterTest, matchesDefaultSettings) {
+  Json::StreamWriterBuilder builder;
+  checkMatchesBuilder(builder);
+}
+
+JSONTEST_FIXTURE_LOCAL(StreamingWriterTest, matchesCustomSettings) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  checkMatchesBuilder(builder);
+  builder["indentation"] = "  ";
+  builder["emitUTF8"] = true;
+  builder["precision"] = 3;
+  builder["enableYAMLCompatibility"] = true;
+  checkMatchesBuilder(builder);
+  builder["precisionType"] = "decimal";
+  builder["dropNullPlaceholders"] = true;
+  checkMatchesBuilder(builder);
+}
+
+JSONTEST_FIXTURE_LOCAL(StreamingWriterTest, writeValueFragments) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  Json::Value fragment;
+  fragment["b"][0] = 1;
+  fragment["a"] = Json::Value::maxLargestUInt;
+  Json::OStringStream sout;
+  Json::StreamingWriter writer(builder, &sout);
+  writer.beginArray().value(fragment).value(-1).endArray();
+  JSONTEST_ASSERT(writer.isComplete());
+  JSONTEST_ASSERT_STRING_EQUAL("[{\"a\":18446744073709551615,\"b\":[1]},-1]",
+                               sout.str());
+}
+
+JSONTEST_FIXTURE_LOCAL(StreamingWriterTest, writeRootScalar) {
+  Json::StreamWriterBuilder builder;
+  Json::OStringStream sout;
+  Json::StreamingWriter writer(builder, &sout);
+  JSONTEST_ASSERT(!writer.isComplete());
+  const char name[] = "a\0b";
+  writer.value(name, name + 3);
+  JSONTEST_ASSERT(writer.isComplete());
+  JSONTEST_ASSERT_STRING_EQUAL("\"a\\u0000b\"", sout.str());
+}
+
+#if !defined(NDEBUG) && JSON_USE_EXCEPTION
+JSONTEST_FIXTURE_LOCAL(StreamingWriterTest, invalidNesting) {
+  Json::StreamWriterBuilder builder;
+  Json::OStringStream sout;
+  {
+    Json::StreamingWriter writer(builder, &sout);
+    writer.beginObject();
+    JSONTEST_ASSERT_THROWS(writer.value(1));
+    JSONTEST_ASSERT_THROWS(writer.endArray());
+  }
+  {
+    Json::StreamingWriter writer(builder, &sout);
+    JSONTEST_ASSERT_THROWS(writer.key("a"));
+    writer.value(1);
+    JSONTEST_ASSERT_THROWS(writer.value(2));
+  }
+}
+#endif
+
+struct ParallelWriterTest : JsonTest::TestCase {
+  static Json::Value largeDocument() {
+    Json::Value root;
+    for (int i = 0; i < 200; ++i) {
+      Json::Value& record = root["records"][i];
+      record["id"] = i;
+      record["name"] = "record " + std::to_string(i);
+      record["ratio"] = i / 7.0;
+      record["tags"].append("a");
+      record["tags"].append(i % 3 == 0);
+      record["empty"] = Json::arrayValue;
+      if (i % 10 == 0)
+        record["id"].setComment(Json::String("// every tenth"),
+                                Json::commentAfterOnSameLine);
+      if (i % 25 == 0)
+        root["records"][i].setComment(Json::String("/* block */"),
+                                      Json::commentBefore);
+      root["index"]["key" + std::to_string(i)] = i * 2;
+    }
+    root["index"]["key7"].setComment(Json::String("// after"),
+                                     Json::commentAfter);
+    return root;
+  }
+
+  void checkParallelMatchesSerial(Json::StreamWriterBuilder builder) {
+    Json::Value const root = largeDocument();
+    Json::String const serial = Json::writeString(builder, root);
+    builder["parallelThreshold"] = 3;
+    builder["parallelThreads"] = 4;
+    JSONTEST_ASSERT(builder.validate(nullptr));
+    JSONTEST_ASSERT_STRING_EQUAL(serial, Json::writeString(builder, root));
+    builder["parallelThreads"] = 0;
+    JSONTEST_ASSERT_STRING_EQUAL(serial, Json::writeString(builder, root));
+  }
+};
+
+JSONTEST_FIXTURE_LOCAL(ParallelWriterTest, matchesSerialOutput) {
+  Json::StreamWriterBuilder builder;
+  checkParallelMatchesSerial(builder);
+  builder["indentation"] = "";
+  checkParallelMatchesSerial(builder);
+  builder["indentation"] = "  ";
+  builder["commentStyle"] = "None";
+  checkParallelMatchesSerial(builder);
+}
+
+JSONTEST_FIXTURE_LOCAL(ParallelWriterTest, smallContainersStaySerial) {
+  Json::StreamWriterBuilder builder;
+  builder["parallelThreshold"] = 1000;
+  builder["parallelThreads"] = 4;
+  Json::Value root;
+  root["a"].append(1);
+  root["b"] = "x";
+  JSONTEST_ASSERT_STRING_EQUAL("{\n\t\"a\" : \n\t[\n\t\t1\n\t],\n\t\"b\" : \"x\"\n}",
+                               Json::writeString(builder, root));
+}
+
+struct SerializedSizeHintTest : JsonTest::TestCase {
+  static Json::Value sampleDocument() {
+    Json::Value root;
+    root["int"] = Json::Value::minLargestInt;
+    root["uint"] = Json::Value::maxLargestUInt;
+    root["zero"] = 0;
+    root["bool"] = false;
+    root["null"] = Json::nullValue;
+    root["escapes"] = "tab\tquote\"\x01\xe2\x82\xac\xf0\x9f\x98\x80";
+    root["nested"]["array"].append(Json::arrayValue);
+    root["nested"]["array"].append(Json::objectValue);
+    root["nested"]["array"].append("x");
+    root["nested"]["empty"] = Json::objectValue;
+    root["nested"].setComment(Json::String("// nested"), Json::commentBefore);
+    root["bool"].setComment(Json::String("// same line"),
+                            Json::commentAfterOnSameLine);
+    root.setComment(Json::String("/* root */"), Json::commentAfter);
+    return root;
+  }
+};
+
+JSONTEST_FIXTURE_LOCAL(SerializedSizeHintTest, exactForCompactOutput) {
+  Json::Value const root = sampleDocument();
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  JSONTEST_ASSERT_EQUAL(Json::writeString(builder, root).size(),
+                        Json::serializedSizeHint(root, builder));
+  builder["emitUTF8"] = true;
+  builder["dropNullPlaceholders"] = true;
+  builder["enableYAMLCompatibility"] = true;
+  JSONTEST_ASSERT_EQUAL(Json::writeString(builder, root).size(),
+                        Json::serializedSizeHint(root, builder));
+  builder["commentStyle"] = "None";
+  JSONTEST_ASSERT_EQUAL(Json::writeString(builder, root).size(),
+                        Json::serializedSizeHint(root, builder));
+}
+
+JSONTEST_FIXTURE_LOCAL(SerializedSizeHintTest, upperBoundWithIndentation) {
+  Json::Value root = sampleDocument();
+  root["reals"].append(0.1);
+  root["reals"].append(-1.5e300);
+  root["reals"].append(12345.678);
+  root["reals"].append(std::numeric_limits<double>::quiet_NaN());
+  Json::StreamWriterBuilder builder;
+  JSONTEST_ASSERT(Json::writeString(builder, root).size() <=
+                  Json::serializedSizeHint(root, builder));
+  builder["commentStyle"] = "None";
+  builder["indentation"] = "    ";
+  JSONTEST_ASSERT(Json::writeString(builder, root).size() <=
+                  Json::serializedSizeHint(root, builder));
+  builder["precisionType"] = "decimal";
+  builder["useSpecialFloats"] = true;
+  builder["indentation"] = "";
+  JSONTEST_ASSERT(Json::writeString(builder, root).size() <=
+                  Json::serializedSizeHint(root, builder));
+}
+
+struct CompactStreamWriterTest : JsonTest::TestCase {
+  static Json::Value sampleDocument() {
+    Json::Value root;
+    root["sparse"][3] = 1;
+    root["sparse"][1] = Json::objectValue;
+    root["ints"].append(Json::Value::minLargestInt);
+    root["ints"].append(Json::Value::maxLargestUInt);
+    root["reals"].append(0.1);
+    root["reals"].append(-2.5e-300);
+    root["reals"].append(1e20);
+    root["reals"].append(3.0);
+    root["reals"].append(std::numeric_limits<double>::infinity());
+    root["reals"].append(std::numeric_limits<double>::quiet_NaN());
+    root["strings"].append("plain");
+    root["strings"].append("\"\\\b\f\n\r\t\x01\x7f");
+    root["strings"].append("\xe2\x82\xac\xf0\x9f\x98\x80\xff");
+    root["strings"].append(Json::String("nul\0byte", 8));
+    root["key\twith\xc3\xa9"] = true;
+    root["null"] = Json::nullValue;
+    root["empty"]["array"] = Json::arrayValue;
+    root["empty"]["object"] = Json::objectValue;
+    root["ints"].setComment(Json::String("// ints"), Json::commentBefore);
+    root["null"].setComment(Json::String("// same line"),
+                            Json::commentAfterOnSameLine);
+    root["reals"][1].setComment(Json::String("/* after */"),
+                                Json::commentAfter);
+    return root;
+  }
+
+  // A non-zero parallelThreshold keeps the general BuiltStyledStreamWriter,
+  // which serves as the reference for the specialized compact writer.
+  void checkMatchesGeneralWriter(Json::StreamWriterBuilder builder) {
+    Json::Value const root = sampleDocument();
+    builder["indentation"] = "";
+    Json::String const compact = Json::writeString(builder, root);
+    builder["parallelThreshold"] = Json::Value::maxUInt;
+    JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(builder, root), compact);
+  }
+};
+
+JSONTEST_FIXTURE_LOCAL(CompactStreamWriterTest, matchesGeneralWriter) {
+  Json::StreamWriterBuilder builder;
+  checkMatchesGeneralWriter(builder);
+  builder["emitUTF8"] = true;
+  checkMatchesGeneralWriter(builder);
+  builder["useSpecialFloats"] = true;
+  builder["commentStyle"] = "None";
+  checkMatchesGeneralWriter(builder);
+  builder["precisionType"] = "decimal";
+  builder["precision"] = 3;
+  builder["dropNullPlaceholders"] = true;
+  builder["enableYAMLCompatibility"] = true;
+  checkMatchesGeneralWriter(builder);
+  builder["emitUTF8"] = false;
+  builder["commentStyle"] = "All";
+  checkMatchesGeneralWriter(builder);
+}
+
+JSONTEST_FIXTURE_LOCAL(CompactStreamWriterTest, writeCompactDocument) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  Json::Value root;
+  root["a"][2] = 1.5;
+  root["b"] = "x\ny";
+  JSONTEST_ASSERT_STRING_EQUAL("{\"a\":[null,null,1.5],\"b\":\"x\\ny\"}",
+                               Json::writeString(builder, root));
+}
+
+struct SerializationCacheTest : JsonTest::TestCase {
+  static Json::Value catalog() {
+    Json::Value root;
+    for (int i = 0; i < 3; ++i) {
+      Json::Value& item = root["items"].append(Json::objectValue);
+      item["id"] = i;
+      item["tags"].append("t" + std::to_string(i));
+      item["tags"].append(i * 0.5);
+    }
+    root["name"] = "catalog";
+    root["name"].setComment(Json::String("// name"), Json::commentBefore);
+    return root;
+  }
+
+  // A copy starts without a cache, so writing it gives the reference output.
+  void checkWrites(Json::Value const& root) {
+    Json::StreamWriterBuilder builder;
+    JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(builder, Json::Value(root)),
+                                 Json::writeString(builder, root));
+    JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(builder, Json::Value(root)),
+                                 Json::writeString(builder, root));
+    builder["indentation"] = "";
+    JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(builder, Json::Value(root)),
+                                 Json::writeString(builder, root));
+    builder["parallelThreshold"] = Json::Value::maxUInt;
+    JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(builder, Json::Value(root)),
+                                 Json::writeString(builder, root));
+  }
+
+  static bool isCached(Json::Value const& value) {
+    Json::String fragment;
+    return value.findCachedSerialization("test", &fragment);
+  }
+};
+
+JSONTEST_FIXTURE_LOCAL(SerializationCacheTest, writesMatchUncachedOutput) {
+  Json::Value root = catalog();
+  root.enableSerializationCache();
+  root["items"][1].enableSerializationCache();
+  root["items"][1]["tags"].enableSerializationCache();
+  checkWrites(root);
+  root["items"][1]["tags"][0] = "changed";
+  checkWrites(root);
+  root["items"][2]["id"] = 7;
+  checkWrites(root);
+  root["items"].append(root["items"][1]);
+  checkWrites(root);
+  root["items"][1]["tags"].setComment(Json::String("// tags"),
+                                      Json::commentAfter);
+  checkWrites(root);
+  root["items"][1] = "replaced";
+  checkWrites(root);
+  root.removeMember("name");
+  checkWrites(root);
+}
+
+JSONTEST_FIXTURE_LOCAL(SerializationCacheTest, mutatorsInvalidateAncestors) {
+  Json::Value root = catalog();
+  Json::Value& item = root["items"][1];
+  root.enableSerializationCache();
+  item.enableSerializationCache();
+  JSONTEST_ASSERT(root.hasSerializationCache());
+  JSONTEST_ASSERT(!root["items"].hasSerializationCache());
+
+  auto store = [&]() {
+    root.storeCachedSerialization("test", "root");
+    item.storeCachedSerialization("test", "item");
+    JSONTEST_ASSERT(isCached(root) && isCached(item));
+  };
+
+  store();
+  item["tags"][0] = 1;
+  JSONTEST_ASSERT(!isCached(root) && !isCached(item));
+
+  store();
+  root["items"][0]["id"] = 5;
+  JSONTEST_ASSERT(!isCached(root) && isCached(item));
+
+  store();
+  item["tags"].append(true);
+  JSONTEST_ASSERT(!isCached(root) && !isCached(item));
+
+  store();
+  item.removeMember("id");
+  JSONTEST_ASSERT(!isCached(root) && !isCached(item));
+
+  store();
+  Json::Value other(Json::arrayValue);
+  other.append(1);
+  item["tags"].swap(other);
+  JSONTEST_ASSERT(!isCached(root) && !isCached(item));
+
+  // Values moved into the subtree join its cache.
+  store();
+  Json::Value moved;
+  moved["deep"]["leaf"] = 1;
+  item["moved"] = std::move(moved);
+  JSONTEST_ASSERT(!isCached(root) && !isCached(item));
+  store();
+  item["moved"]["deep"]["leaf"] = 2;
+  JSONTEST_ASSERT(!isCached(root) && !isCached(item));
+
+  store();
+  root["items"].removeIndex(0, nullptr);
+  JSONTEST_ASSERT(!isCached(root));
+
+  // Reading a value never invalidates.
+  store();
+  JSONTEST_ASSERT_EQUAL(2, root["items"][0]["moved"]["deep"]["leaf"].asInt());
+  JSONTEST_ASSERT(isCached(root));
+}
+
+JSONTEST_FIXTURE_LOCAL(SerializationCacheTest, cacheStaysWithTheObject) {
+  Json::Value root = catalog();
+  root.enableSerializationCache();
+  root.storeCachedSerialization("test", "root");
+
+  Json::Value copy(root);
+  JSONTEST_ASSERT(!copy.hasSerializationCache());
+  copy["name"] = "copy";
+  JSONTEST_ASSERT(isCached(root));
+
+  Json::Value moved(std::move(root));
+  JSONTEST_ASSERT(!moved.hasSerializationCache());
+  JSONTEST_ASSERT(root.hasSerializationCache());
+  JSONTEST_ASSERT(!isCached(root));
+  moved["name"] = "moved";
+
+  root.disableSerializationCache();
+  JSONTEST_ASSERT(!root.hasSerializationCache());
+  root.storeCachedSerialization("test", "root");
+  JSONTEST_ASSERT(!isCached(root));
+}
+
+JSONTEST_FIXTURE_LOCAL(SerializationCacheTest, movesKeepLabelsConsistent) {
+  Json::Value root = catalog();
+  Json::Value& items = root["items"];
+  root.enableSerializationCache();
+  items[1].enableSerializationCache();
+  auto store = [&]() {
+    root.storeCachedSerialization("test", "root");
+    JSONTEST_ASSERT(isCached(root));
+  };
+
+  // Elements swapped within the domain are already labelled with it.
+  store();
+  std::swap(items[0], items[2]);
+  JSONTEST_ASSERT(!isCached(root));
+  checkWrites(root);
+  store();
+  items[0]["tags"][0] = "swapped";
+  JSONTEST_ASSERT(!isCached(root));
+  checkWrites(root);
+
+  // A value moved out and back in still invalidates the domain.
+  Json::Value out = std::move(items[2]);
+  out["id"] = 9;
+  items[2] = std::move(out);
+  store();
+  items[2]["tags"][1] = false;
+  JSONTEST_ASSERT(!isCached(root));
+  checkWrites(root);
+
+  // A subtree still labelled with another tree's domain is relabelled.
+  Json::Value other = catalog();
+  other.enableSerializationCache();
+  root["stolen"] = std::move(other["items"]);
+  store();
+  root["stolen"][0]["tags"][0] = "stolen";
+  JSONTEST_ASSERT(!isCached(root));
+  checkWrites(root);
+}
+
+struct AllocationObserverTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(AllocationObserverTest, countsPerSite) {
+  Json::AllocationCounter counter;
+  if (!Json::setAllocationObserver(&counter)) {
+    // Built without allocation hooks: nothing is ever reported.
+    Json::Value value(Json::objectValue);
+    value["member"] = "text";
+    JSONTEST_ASSERT_EQUAL(0u, counter.totalCount());
+    return;
+  }
+
+  Json::Value root;
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  Json::String const doc = "// before\n{\"a\": [1, 2], \"b\": \"x\"}";
+  JSONTEST_ASSERT(reader->parse(doc.data(), doc.data() + doc.size(), &root,
+                                nullptr));
+  JSONTEST_ASSERT(counter.count(Json::readerComment) > 0);
+  JSONTEST_ASSERT(counter.count(Json::commentStorage) > 0);
+  JSONTEST_ASSERT(counter.count(Json::objectValuesNode) >= 4);
+
+  counter.reset();
+  JSONTEST_ASSERT_EQUAL(0u, counter.totalCount());
+  Json::Value const copy(root);
+  JSONTEST_ASSERT_EQUAL(4u, counter.count(Json::objectValuesNode));
+  JSONTEST_ASSERT_EQUAL(2u, counter.count(Json::objectValuesMap));
+  JSONTEST_ASSERT_EQUAL(2u, counter.count(Json::duplicatedString));
+  JSONTEST_ASSERT_EQUAL(1u, counter.count(Json::prefixedString));
+  JSONTEST_ASSERT_EQUAL(1u, counter.count(Json::commentStorage));
+  JSONTEST_ASSERT(counter.totalBytes() >= counter.bytes(Json::prefixedString));
+
+  counter.reset();
+  Json::String errors;
+  Json::String const bad = "[1, }";
+  JSONTEST_ASSERT(!reader->parse(bad.data(), bad.data() + bad.size(), &root,
+                                 &errors));
+  JSONTEST_ASSERT(counter.count(Json::readerError) > 0);
+
+  JSONTEST_ASSERT(Json::setAllocationObserver(nullptr));
+  counter.reset();
+  Json::Value const other(copy);
+  JSONTEST_ASSERT_EQUAL(0u, counter.totalCount());
+  JSONTEST_ASSERT_STRING_EQUAL("duplicateStringValue",
+                               Json::allocationSiteName(Json::duplicatedString));
+}
+
+JSONTEST_FIXTURE_LOCAL(AllocationObserverTest, observerMayCopyValues) {
+  // An observer that copies trees while the library is copying one.
+  struct CopyingObserver : Json::AllocationObserver {
+    Json::Value source;
+    size_t copies = 0;
+    bool copying = false;
+    void allocated(Json::AllocationSite, size_t) override {
+      if (copying)
+        return;
+      copying = true;
+      Json::Value const copy(source);
+      copies += copy == source;
+      copying = false;
+    }
+  } observer;
+  observer.source["list"].append(Json::Value(Json::objectValue));
+  observer.source["list"][0]["x"] = 1;
+  if (!Json::setAllocationObserver(&observer))
+    return;
+
+  Json::Value root;
+  root["a"]["b"].append("c");
+  root["a"]["d"] = Json::Value(Json::arrayValue);
+  Json::Value const copy(root);
+  Json::setAllocationObserver(nullptr);
+  JSONTEST_ASSERT(copy == root);
+  JSONTEST_ASSERT(observer.copies > 0);
+}
+
+struct PhaseStatsTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(PhaseStatsTest, parseCountsTokensAndPaths) {
+  Json::CharReaderBuilder builder;
+  Json::ParseStats stats;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader(&stats));
+  Json::Value root;
+  Json::String const doc =
+      "{\"a\": [1, -2.5, \"x\\ty\"], \"b\\\"\": true, \"c\": null, "
+      "\"d\": {}}  ";
+  JSONTEST_ASSERT(
+      reader->parse(doc.data(), doc.data() + doc.size(), &root, nullptr));
+  JSONTEST_ASSERT_EQUAL(doc.size() - 2, stats.bytesConsumed);
+  JSONTEST_ASSERT_EQUAL(2u, stats.objects);
+  JSONTEST_ASSERT_EQUAL(1u, stats.arrays);
+  JSONTEST_ASSERT_EQUAL(5u, stats.strings);
+  JSONTEST_ASSERT_EQUAL(4u, stats.memberNames);
+  JSONTEST_ASSERT_EQUAL(2u, stats.numbers);
+  JSONTEST_ASSERT_EQUAL(2u, stats.literals);
+  JSONTEST_ASSERT_EQUAL(2u, stats.escapes);
+  JSONTEST_ASSERT_EQUAL(1u, stats.integers);
+  JSONTEST_ASSERT_EQUAL(1u, stats.doubles);
+  JSONTEST_ASSERT_EQUAL(3u, stats.maxDepth);
+  JSONTEST_ASSERT_EQUAL(8u, stats.nodes);
+  JSONTEST_ASSERT(stats.parseNanoseconds >= stats.stringNanoseconds);
+
+  // Every parse starts from zero.
+  Json::String const scalar = "42";
+  JSONTEST_ASSERT(reader->parse(scalar.data(), scalar.data() + scalar.size(),
+                                &root, nullptr));
+  JSONTEST_ASSERT_EQUAL(2u, stats.bytesConsumed);
+  JSONTEST_ASSERT_EQUAL(0u, stats.strings);
+  JSONTEST_ASSERT_EQUAL(1u, stats.integers);
+  JSONTEST_ASSERT_EQUAL(1u, stats.maxDepth);
+  JSONTEST_ASSERT_EQUAL(1u, stats.nodes);
+
+  reader.reset(builder.newCharReader());
+  JSONTEST_ASSERT(
+      reader->parse(doc.data(), doc.data() + doc.size(), &root, nullptr));
+  JSONTEST_ASSERT_EQUAL(1u, stats.nodes);
+}
+
+JSONTEST_FIXTURE_LOCAL(PhaseStatsTest, writeCountsMatchOutput) {
+  Json::Value root(Json::objectValue);
+  root["a"].append(1);
+  root["a"].append(-2.5);
+  root["a"].append("x\ty\xc3\xa9");
+  root["b\""] = true;
+  root["c"] = Json::Value();
+  root["d"] = Json::Value(Json::objectValue);
+
+  for (char const* indentation : {"", "  "}) {
+    for (int parallelThreshold : {0, 1}) {
+      Json::StreamWriterBuilder builder;
+      builder["indentation"] = indentation;
+      builder["parallelThreshold"] = parallelThreshold;
+      builder["parallelThreads"] = 2;
+      Json::WriteStats stats;
+      std::unique_ptr<Json::StreamWriter> writer(
+          builder.newStreamWriter(&stats));
+      Json::OStringStream out;
+      out << "prefix";
+      JSONTEST_ASSERT_EQUAL(0, writer->write(root, &out));
+      JSONTEST_ASSERT_EQUAL(out.str().size() - 6, stats.bytesWritten);
+      JSONTEST_ASSERT_EQUAL(2u, stats.objects);
+      JSONTEST_ASSERT_EQUAL(1u, stats.arrays);
+      JSONTEST_ASSERT_EQUAL(5u, stats.strings);
+      JSONTEST_ASSERT_EQUAL(4u, stats.memberNames);
+      JSONTEST_ASSERT_EQUAL(1u, stats.integers);
+      JSONTEST_ASSERT_EQUAL(1u, stats.reals);
+      JSONTEST_ASSERT_EQUAL(2u, stats.literals);
+      JSONTEST_ASSERT_EQUAL(3u, stats.escapes);
+      JSONTEST_ASSERT_EQUAL(3u, stats.maxDepth);
+      JSONTEST_ASSERT_EQUAL(8u, stats.nodes);
+
+      builder["emitUTF8"] = true;
+      writer.reset(builder.newStreamWriter(&stats));
+      out.str("");
+      writer->write(root, &out);
+      JSONTEST_ASSERT_EQUAL(out.str().size(), stats.bytesWritten);
+      JSONTEST_ASSERT_EQUAL(2u, stats.escapes);
+    }
+  }
+}
+
+JSONTEST_FIXTURE_LOCAL(PhaseStatsTest, writeCountsSplicedValues) {
+  Json::Value root(Json::objectValue);
+  root["a"].append("x\n");
+  root["a"].append(Json::Value(Json::objectValue));
+  root["a"][1]["b"] = 1;
+  root["a"].enableSerializationCache();
+
+  for (char const* indentation : {"", "  "}) {
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = indentation;
+    Json::WriteStats stats;
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter(&stats));
+    for (int pass = 0; pass < 2; ++pass) {
+      Json::OStringStream out;
+      writer->write(root, &out);
+      JSONTEST_ASSERT_EQUAL(out.str().size(), stats.bytesWritten);
+      JSONTEST_ASSERT_EQUAL(2u, stats.objects);
+      JSONTEST_ASSERT_EQUAL(1u, stats.arrays);
+      JSONTEST_ASSERT_EQUAL(3u, stats.strings);
+      JSONTEST_ASSERT_EQUAL(2u, stats.memberNames);
+      JSONTEST_ASSERT_EQUAL(1u, stats.escapes);
+      JSONTEST_ASSERT_EQUAL(4u, stats.maxDepth);
+      JSONTEST_ASSERT_EQUAL(5u, stats.nodes);
+    }
+  }
+}
+
+struct MemoryUsageTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(MemoryUsageTest, countsEveryKindOfStorage) {
+  Json::Value root(Json::objectValue);
+  root["name"] = "hello";
+  root["list"].append(1);
+  root["list"].append(2.5);
+  root["list"].append(true);
+  root["list"].append(Json::Value());
+  root["nested"]["k"] = "v";
+
+  Json::MemoryUsage const usage = root.memoryUsage();
+  JSONTEST_ASSERT_EQUAL(9u, usage.nodes);
+  JSONTEST_ASSERT_EQUAL(2u, usage.countByType[Json::objectValue]);
+  JSONTEST_ASSERT_EQUAL(1u, usage.countByType[Json::arrayValue]);
+  JSONTEST_ASSERT_EQUAL(2u, usage.countByType[Json::stringValue]);
+  JSONTEST_ASSERT_EQUAL(1u, usage.countByType[Json::intValue]);
+  JSONTEST_ASSERT_EQUAL(1u, usage.countByType[Json::realValue]);
+  JSONTEST_ASSERT_EQUAL(1u, usage.countByType[Json::booleanValue]);
+  JSONTEST_ASSERT_EQUAL(1u, usage.countByType[Json::nullValue]);
+  JSONTEST_ASSERT_EQUAL(3u, usage.maxDepth);
+  JSONTEST_ASSERT_EQUAL(4u, usage.objectMembers);
+  JSONTEST_ASSERT_EQUAL(2.0, usage.averageFanOut());
+  JSONTEST_ASSERT_EQUAL(9 * sizeof(Json::Value), usage.valueBytes);
+  // "name", "list", "nested" and "k", each with its terminator.
+  JSONTEST_ASSERT_EQUAL(19u, usage.keyBytes);
+  JSONTEST_ASSERT_EQUAL(2 * sizeof(unsigned) + 6 + 2, usage.stringBytes);
+  JSONTEST_ASSERT_EQUAL(0u, usage.commentBytes);
+  JSONTEST_ASSERT_EQUAL(usage.valueBytes + usage.mapBytes + usage.keyBytes +
+                            usage.stringBytes,
+                        usage.totalBytes());
+
+  // Every element costs the same map node overhead.
+  root["list"].append(3);
+  Json::MemoryUsage const one = root.memoryUsage();
+  root["list"].append(4);
+  Json::MemoryUsage const two = root.memoryUsage();
+  JSONTEST_ASSERT(one.mapBytes > usage.mapBytes);
+  JSONTEST_ASSERT_EQUAL(one.mapBytes - usage.mapBytes,
+                        two.mapBytes - one.mapBytes);
+
+  // Static strings are not owned by the tree; comments are.
+  root["static"] = Json::StaticString("not copied");
+  root.setComment(Json::String("// a comment"), Json::commentBefore);
+  Json::MemoryUsage const last = root.memoryUsage();
+  JSONTEST_ASSERT_EQUAL(two.stringBytes, last.stringBytes);
+  JSONTEST_ASSERT(last.commentBytes > 0);
+
+  Json::MemoryUsage const scalar = Json::Value(7).memoryUsage();
+  JSONTEST_ASSERT_EQUAL(1u, scalar.maxDepth);
+  JSONTEST_ASSERT_EQUAL(sizeof(Json::Value), scalar.totalBytes());
+  JSONTEST_ASSERT_EQUAL(0.0, scalar.averageFanOut());
+}
+
+struct ArrayEditTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(ArrayEditTest, singleElementEditsMoveNeighbours) {
+  Json::Value array;
+  JSONTEST_ASSERT(array.insert(0, "b"));
+  JSONTEST_ASSERT(array.insert(0, "a"));
+  JSONTEST_ASSERT(array.insert(2, "d"));
+  JSONTEST_ASSERT(array.insert(2, "c"));
+  JSONTEST_ASSERT(!array.insert(5, "f"));
+  array[3].setComment(Json::String("// last"), Json::commentBefore);
+  JSONTEST_ASSERT_STRING_EQUAL("[\"a\",\"b\",\"c\",\"d\"]\n",
+                               Json::FastWriter().write(array));
+
+  Json::Value removed;
+  JSONTEST_ASSERT(array.removeIndex(1, &removed));
+  JSONTEST_ASSERT_STRING_EQUAL("b", removed.asString());
+  JSONTEST_ASSERT_EQUAL(3u, array.size());
+  JSONTEST_ASSERT_STRING_EQUAL("c", array[1].asString());
+  JSONTEST_ASSERT(array[2].hasComment(Json::commentBefore));
+  JSONTEST_ASSERT(!array.removeIndex(3, &removed));
+}
+
+JSONTEST_FIXTURE_LOCAL(ArrayEditTest, bulkEditsKeepOrder) {
+  Json::Value array(Json::arrayValue);
+  for (int i = 0; i < 10; ++i)
+    array.append(i);
+
+  JSONTEST_ASSERT_EQUAL(3u, array.eraseRange(2, 5));
+  JSONTEST_ASSERT_EQUAL(0u, array.eraseRange(4, 4));
+  JSONTEST_ASSERT_EQUAL(2u, array.eraseRange(5, 100));
+  JSONTEST_ASSERT_EQUAL(5u, array.size());
+  JSONTEST_ASSERT_EQUAL(5, array[2].asInt());
+  JSONTEST_ASSERT_EQUAL(7, array[4].asInt());
+
+  JSONTEST_ASSERT_EQUAL(
+      3u, array.eraseIf([](Json::Value const& v) { return v.asInt() % 2; }));
+  JSONTEST_ASSERT_EQUAL(2u, array.size());
+  JSONTEST_ASSERT_EQUAL(0, array[0].asInt());
+  JSONTEST_ASSERT_EQUAL(6, array[1].asInt());
+
+  std::vector<int> const numbers{1, 2, 3};
+  JSONTEST_ASSERT(array.insertRange(1, numbers.begin(), numbers.end()));
+  std::vector<Json::Value> texts{Json::Value("x"), Json::Value("y")};
+  JSONTEST_ASSERT(array.insertRange(array.size(),
+                                    std::make_move_iterator(texts.begin()),
+                                    std::make_move_iterator(texts.end())));
+  JSONTEST_ASSERT(!array.insertRange(10, numbers.begin(), numbers.end()));
+  JSONTEST_ASSERT_STRING_EQUAL("[0,1,2,3,6,\"x\",\"y\"]\n",
+                               Json::FastWriter().write(array));
+
+  JSONTEST_ASSERT_EQUAL(
+      5u, array.retainIf([](Json::Value const& v) { return v.isString(); }));
+  JSONTEST_ASSERT_EQUAL(2u, array.size());
+  JSONTEST_ASSERT_STRING_EQUAL("y", array[1].asString());
+
+  Json::Value object(Json::objectValue);
+  object["a"] = 1;
+  JSONTEST_ASSERT_EQUAL(0u, object.eraseRange(0, 1));
+  JSONTEST_ASSERT_EQUAL(
+      0u, object.eraseIf([](Json::Value const&) { return true; }));
+  JSONTEST_ASSERT_EQUAL(1u, object.size());
+}
+
+JSONTEST_FIXTURE_LOCAL(ArrayEditTest, sparseArraysKeepPositions) {
+  Json::Value array;
+  array[0] = "a";
+  array[3] = "b";
+  Json::Value removed;
+  JSONTEST_ASSERT(!array.removeIndex(1, &removed));
+  JSONTEST_ASSERT(array.removeIndex(0, &removed));
+  JSONTEST_ASSERT_STRING_EQUAL("a", removed.asString());
+  JSONTEST_ASSERT_STRING_EQUAL("[null,null,\"b\"]\n",
+                               Json::FastWriter().write(array));
+
+  Json::Value last;
+  last[3] = "last";
+  Json::Value inserted(last);
+  JSONTEST_ASSERT(inserted.insert(0, "x"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"x\",null,null,null,\"last\"]\n",
+                               Json::FastWriter().write(inserted));
+  Json::Value ranged(last);
+  std::vector<int> const numbers{1, 2};
+  JSONTEST_ASSERT(ranged.insertRange(2, numbers.begin(), numbers.end()));
+  JSONTEST_ASSERT_STRING_EQUAL("[null,null,1,2,null,\"last\"]\n",
+                               Json::FastWriter().write(ranged));
+
+  Json::Value erased(last);
+  JSONTEST_ASSERT_EQUAL(1u, erased.eraseRange(0, 1));
+  JSONTEST_ASSERT_STRING_EQUAL("[null,null,\"last\"]\n",
+                               Json::FastWriter().write(erased));
+  JSONTEST_ASSERT_EQUAL(
+      2u, erased.eraseIf([](Json::Value const& v) { return v.isNull(); }));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"last\"]\n",
+                               Json::FastWriter().write(erased));
+}
+
+struct ArrayViewTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(ArrayViewTest, sortsInPlace) {
+  Json::Value array(Json::arrayValue);
+  for (int i : {5, 3, 9, 1, 7})
+    array.append(i);
+  array[0].setComment(Json::String("// five"), Json::commentBefore);
+  Json::Value const* const third = &array[2];
+
+  Json::ArrayView view(array);
+  JSONTEST_ASSERT_EQUAL(5u, view.size());
+  JSONTEST_ASSERT_EQUAL(5, view.end() - view.begin());
+  JSONTEST_ASSERT_EQUAL(9, view.begin()[2].asInt());
+  std::sort(view.begin(), view.end());
+  JSONTEST_ASSERT_STRING_EQUAL("[1,3,5,7,9]\n",
+                               Json::FastWriter().write(array));
+  JSONTEST_ASSERT(array[2].hasComment(Json::commentBefore));
+  JSONTEST_ASSERT(third == &array[2]);
+
+  auto const found =
+      std::lower_bound(view.begin(), view.end(), Json::Value(6));
+  JSONTEST_ASSERT_EQUAL(3, found - view.begin());
+  JSONTEST_ASSERT_EQUAL(7, found->asInt());
+  auto it = view.end();
+  it -= 2;
+  JSONTEST_ASSERT(it == found);
+  JSONTEST_ASSERT(view.begin() + 3 == found && 3 + view.begin() == found);
+  JSONTEST_ASSERT(view.begin() < found && found <= it && !(found > it));
+}
+
+JSONTEST_FIXTURE_LOCAL(ArrayViewTest, refreshFollowsResize) {
+  Json::Value array(Json::arrayValue);
+  array.append("b");
+  Json::ArrayView view(array);
+  array.append("a");
+  JSONTEST_ASSERT_EQUAL(1u, view.size());
+  view.refresh();
+  JSONTEST_ASSERT_EQUAL(2u, view.size());
+  std::reverse(view.begin(), view.end());
+  JSONTEST_ASSERT_STRING_EQUAL("a", array[0].asString());
+
+  Json::Value const& constant = array;
+  Json::ConstArrayView constView(constant);
+  JSONTEST_ASSERT_STRING_EQUAL("b", constView[1].asString());
+  JSONTEST_ASSERT(std::is_sorted(constView.begin(), constView.end()));
+  Json::Value const null;
+  JSONTEST_ASSERT(Json::ConstArrayView(null).empty());
+}
+
+#if JSON_USE_EXCEPTION
+JSONTEST_FIXTURE_LOCAL(ArrayViewTest, rejectsUnassignedElements) {
+  Json::Value array(Json::arrayValue);
+  array[2] = 3;
+  JSONTEST_ASSERT_THROWS(Json::ArrayView view(array));
+  array[0] = 1;
+  array[1] = 2;
+  Json::ArrayView view(array);
+  JSONTEST_ASSERT_EQUAL(3u, view.size());
+  JSONTEST_ASSERT_EQUAL(2, view[1].asInt());
+}
+#endif
+
+struct KeyViewTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(KeyViewTest, viewsStoredNames) {
+  Json::Value object;
+  object["alpha"] = 1;
+  object[Json::String("be\0ta", 5)] = 2;
+  auto it = object.begin();
+  Json::StringView key = it.keyView();
+  JSONTEST_ASSERT(key == "alpha");
+  JSONTEST_ASSERT_EQUAL(it.name(), key.toString());
+  ++it;
+  key = it.keyView();
+  JSONTEST_ASSERT_EQUAL(5u, key.size());
+  JSONTEST_ASSERT(key == Json::String("be\0ta", 5));
+  JSONTEST_ASSERT(key != "be");
+  JSONTEST_ASSERT(key.data() == it.keyView().data());
+
+  Json::Value array(Json::arrayValue);
+  array.append("x");
+  array.append("y");
+  JSONTEST_ASSERT(array.begin().keyView().empty());
+  JSONTEST_ASSERT_EQUAL(1u, (++array.begin()).index());
+}
+
+JSONTEST_FIXTURE_LOCAL(KeyViewTest, itemsYieldNamesAndValues) {
+  Json::Value object;
+  object["a"] = 1;
+  object["b"] = 2;
+  Json::String names;
+  for (auto const& item : object.items()) {
+    names.append(item.key.data(), item.key.size());
+    item.value = item.value.asInt() * 10;
+  }
+  JSONTEST_ASSERT_STRING_EQUAL("ab", names);
+  JSONTEST_ASSERT_EQUAL(20, object["b"].asInt());
+
+  Json::Value const& constant = object;
+  int sum = 0;
+  for (auto item : constant.items())
+    sum += item.value.asInt();
+  JSONTEST_ASSERT_EQUAL(30, sum);
+
+  Json::Value array(Json::arrayValue);
+  array.append(true);
+  array.append(false);
+  Json::ArrayIndex last = 0;
+  auto const items = array.items();
+  static_assert(
+      std::is_same<std::iterator_traits<decltype(items.begin())>::
+                       iterator_category,
+                   std::input_iterator_tag>::value,
+      "items() dereferences to a temporary, so it is an input iterator");
+  for (auto it = items.begin(); it != items.end(); ++it) {
+    JSONTEST_ASSERT((*it).key.empty());
+    last = it.index();
+  }
+  JSONTEST_ASSERT_EQUAL(1u, last);
+  Json::Value const scalar(1);
+  JSONTEST_ASSERT(scalar.items().begin() == scalar.items().end());
+}
+
+struct CompiledPathTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(CompiledPathTest, findsLikePath) {
+  Json::Value root;
+  root["user"]["name"] = "someone";
+  root["user"]["scores"].append(4);
+  root["user"]["scores"].append(5);
+  root["user"]["nothing"] = Json::Value();
+
+  Json::CompiledPath const scores(".user.scores[1]");
+  JSONTEST_ASSERT_EQUAL(3u, scores.size());
+  JSONTEST_ASSERT_EQUAL(&Json::Path(".user.scores[1]").resolve(root),
+                        scores.find(root));
+  JSONTEST_ASSERT_EQUAL(5, scores.resolve(root).asInt());
+
+  Json::CompiledPath const nothing(Json::Path(".user.nothing"));
+  JSONTEST_ASSERT(nothing.find(root) != nullptr);
+  JSONTEST_ASSERT(nothing.find(root)->isNull());
+  JSONTEST_ASSERT(Json::CompiledPath(".user.missing").find(root) == nullptr);
+  JSONTEST_ASSERT(Json::CompiledPath(".user.scores[2]").find(root) == nullptr);
+  JSONTEST_ASSERT(Json::CompiledPath(".user.name.first").find(root) ==
+                  nullptr);
+  JSONTEST_ASSERT(Json::CompiledPath(".user[0]").find(root) == nullptr);
+  JSONTEST_ASSERT(
+      Json::CompiledPath(".user.name[0]").resolve(root).isNull());
+  JSONTEST_ASSERT_EQUAL(&root, Json::CompiledPath("").find(root));
+
+  Json::Value sparse;
+  sparse["list"][3] = "x";
+  JSONTEST_ASSERT(Json::CompiledPath(".list[1]").find(sparse) == nullptr);
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "x", Json::CompiledPath(".list[3]").find(sparse)->asString());
+}
+
+JSONTEST_FIXTURE_LOCAL(CompiledPathTest, resolveManySharesPrefixes) {
+  std::vector<Json::CompiledPath> const paths{
+      Json::CompiledPath(".user.name"),  Json::CompiledPath(".user.id"),
+      Json::CompiledPath(".tags[0]"),    Json::CompiledPath(""),
+      Json::CompiledPath(".user.name"),  Json::CompiledPath(".user.id.x"),
+      Json::CompiledPath(".tags[1].id")};
+  Json::CompiledPathSet const set(paths);
+  JSONTEST_ASSERT_EQUAL(paths.size(), set.size());
+
+  std::vector<Json::Value const*> out(set.size());
+  for (int record = 0; record < 3; ++record) {
+    Json::Value root;
+    root["user"]["name"] = "user" + std::to_string(record);
+    if (record != 1)
+      root["user"]["id"] = record;
+    root["tags"].append("first");
+    set.resolveMany(root, out.data());
+    for (size_t i = 0; i < paths.size(); ++i)
+      JSONTEST_ASSERT_EQUAL(paths[i].find(root), out[i]);
+    JSONTEST_ASSERT_EQUAL("user" + std::to_string(record), out[0]->asString());
+    JSONTEST_ASSERT_EQUAL(out[0], out[4]);
+    JSONTEST_ASSERT_EQUAL(record != 1, out[1] != nullptr);
+    JSONTEST_ASSERT_EQUAL(&root, out[3]);
+    JSONTEST_ASSERT(out[6] == nullptr);
+  }
+}
+
+struct PointerTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(PointerTest, resolvesSpecificationExamples) {
+  // The example document of RFC 6901, section 5.
+  Json::String const text =
+      R"({"foo": ["bar", "baz"], "": 0, "a/b": 1, "c%d": 2, "e^f": 3,
+          "g|h": 4, "i\\j": 5, "k\"l": 6, " ": 7, "m~n": 8})";
+  Json::Value root;
+  CharReaderPtr reader(Json::CharReaderBuilder().newCharReader());
+  JSONTEST_ASSERT(
+      reader->parse(text.data(), text.data() + text.size(), &root, nullptr));
+
+  JSONTEST_ASSERT_EQUAL(&root, Json::Pointer::resolve(root, ""));
+  JSONTEST_ASSERT_EQUAL(&root["foo"], Json::Pointer::resolve(root, "/foo"));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "bar", Json::Pointer::resolve(root, "/foo/0")->asString());
+  char const* const pointers[] = {"/",    "/a~1b", "/c%d", "/e^f",
+                                  "/g|h", "/i\\j", "/k\"l", "/ ",
+                                  "/m~0n"};
+  int expected = 0;
+  for (char const* pointer : pointers) {
+    Json::Value const* found = Json::Pointer::resolve(root, pointer);
+    JSONTEST_ASSERT(found != nullptr);
+    JSONTEST_ASSERT_EQUAL(expected++, found->asInt());
+  }
+
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/foo/2") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/foo/01") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/foo/-") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/foo/0/x") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "foo") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/m~2n") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/foo/99999999999") ==
+                  nullptr);
+  JSONTEST_ASSERT(!Json::Pointer::isValid("/a~"));
+  JSONTEST_ASSERT(Json::Pointer::isValid("/a~01/~1/"));
+
+  Json::String const longKey = Json::String(200, 'x') + "/";
+  root[longKey] = true;
+  JSONTEST_ASSERT(Json::Pointer::resolve(root, "/" + Json::String(200, 'x') +
+                                                   "~1") == &root[longKey]);
+}
+
+JSONTEST_FIXTURE_LOCAL(PointerTest, makesAndRemoves) {
+  Json::Value root;
+  Json::Value* created = Json::Pointer::make(root, "/a~1b/list/-");
+  JSONTEST_ASSERT(created != nullptr);
+  *created = 1;
+  *Json::Pointer::make(root, "/a~1b/list/1") = 2;
+  JSONTEST_ASSERT_STRING_EQUAL("{\"a/b\":{\"list\":[1,2]}}\n",
+                               Json::FastWriter().write(root));
+  JSONTEST_ASSERT_EQUAL(created, Json::Pointer::make(root, "/a~1b/list/0"));
+  JSONTEST_ASSERT(Json::Pointer::make(root, "/a~1b/list/3") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::make(root, "/a~1b/list/0/x") == nullptr);
+  JSONTEST_ASSERT(Json::Pointer::make(root, "/new/~x") == nullptr);
+  JSONTEST_ASSERT(!root.isMember("new"));
+
+  Json::Value removed;
+  JSONTEST_ASSERT(Json::Pointer::remove(root, "/a~1b/list/0", &removed));
+  JSONTEST_ASSERT_EQUAL(1, removed.asInt());
+  JSONTEST_ASSERT_EQUAL(2,
+                        Json::Pointer::resolve(root, "/a~1b/list/0")->asInt());
+  JSONTEST_ASSERT(!Json::Pointer::remove(root, "/a~1b/list/1"));
+  JSONTEST_ASSERT(!Json::Pointer::remove(root, ""));
+  JSONTEST_ASSERT(Json::Pointer::remove(root, "/a~1b"));
+  JSONTEST_ASSERT(root.empty());
+
+  Json::Value sparse;
+  sparse[3] = "x";
+  JSONTEST_ASSERT(Json::Pointer::resolve(sparse, "/1") == nullptr);
+  JSONTEST_ASSERT(!Json::Pointer::remove(sparse, "/1"));
+  *Json::Pointer::make(sparse, "/1") = 42;
+  JSONTEST_ASSERT_EQUAL(42, Json::Pointer::resolve(sparse, "/1")->asInt());
+  JSONTEST_ASSERT(Json::Value::nullSingleton().isNull());
+}
+
+struct QueryTest : JsonTest::TestCase {
+  QueryTest() {
+    // The example document of RFC 9535, section 1.5.
+    Json::String const text = R"({"store": {
+        "book": [
+          {"category": "reference", "author": "Nigel Rees",
+           "title": "Sayings of the Century", "price": 8.95},
+          {"category": "fiction", "author": "Evelyn Waugh",
+           "title": "Sword of Honour", "price": 12.99},
+          {"category": "fiction", "author": "Herman Melville",
+           "title": "Moby Dick", "isbn": "0-553-21311-3", "price": 8.99},
+          {"category": "fiction", "author": "J. R. R. Tolkien",
+           "title": "The Lord of the Rings", "isbn": "0-395-19395-8",
+           "price": 22.99}],
+        "bicycle": {"color": "red", "price": 399}}})";
+    CharReaderPtr reader(Json::CharReaderBuilder().newCharReader());
+    reader->parse(text.data(), text.data() + text.size(), &root, nullptr);
+  }
+
+  /// Returns the selected values as a compact JSON array.
+  Json::String select(char const* expression) {
+    Json::Query query;
+    Json::String error;
+    JSONTEST_ASSERT(Json::Query::compile(expression, &query, &error))
+        << expression << ": " << error;
+    Json::Value selected(Json::arrayValue);
+    for (Json::Value const* node : query.select(root))
+      selected.append(*node);
+    return Json::FastWriter().write(selected);
+  }
+
+  /// Rewrites JSON text the way select() writes its results.
+  static Json::String compact(Json::String const& text) {
+    Json::Value value;
+    CharReaderPtr reader(Json::CharReaderBuilder().newCharReader());
+    reader->parse(text.data(), text.data() + text.size(), &value, nullptr);
+    return Json::FastWriter().write(value);
+  }
+
+  Json::Value root;
+};
+
+JSONTEST_FIXTURE_LOCAL(QueryTest, selectsSpecificationExamples) {
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[\"Nigel Rees\",\"Evelyn Waugh\",\"Herman Melville\",\"J. R. R. "
+      "Tolkien\"]\n",
+      select("$.store.book[*].author"));
+  JSONTEST_ASSERT_STRING_EQUAL(select("$.store.book[*].author"),
+                               select("$..author"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"red\",399]\n", select("$.store.bicycle.*"));
+  JSONTEST_ASSERT_STRING_EQUAL(compact("[399,8.95,12.99,8.99,22.99]"),
+                               select("$.store..price"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"Moby Dick\"]\n", select("$..book[2].title"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"The Lord of the Rings\"]\n",
+                               select("$..book[-1].title"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"Nigel Rees\",\"Evelyn Waugh\"]\n",
+                               select("$..book[0,1].author"));
+  JSONTEST_ASSERT_STRING_EQUAL(select("$..book[0,1].author"),
+                               select("$..book[:2].author"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"Herman Melville\",\"J. R. R. Tolkien\"]\n",
+                               select("$..book[?@.isbn].author"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"Sayings of the Century\",\"Moby Dick\"]\n",
+                               select("$..book[?@.price<10].title"));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[\"J. R. R. Tolkien\",\"Herman Melville\",\"Evelyn Waugh\",\"Nigel "
+      "Rees\"]\n",
+      select("$.store.book[::-1].author"));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[\"Sword of Honour\",\"Moby Dick\"]\n",
+      select("$.store.book[?@.category == 'fiction' && "
+             "length(@.title) < 16].title"));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[\"Evelyn Waugh\",\"Herman Melville\",\"J. R. R. Tolkien\"]\n",
+      select("$.store.book[?!(@.price < 9 && !@.isbn)].author"));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[{\"color\":\"red\",\"price\":399}]\n",
+      select("$.store[?count(@.*) == 2 && value(@..color) == \"red\"]"));
+  JSONTEST_ASSERT_STRING_EQUAL("[]\n", select("$.store.book[7]"));
+
+  root = Json::Value();
+  root[0]["list"].append(1);
+  root[0]["list"].append(2.5);
+  root[0]["map"]["n"] = 2;
+  root[1]["list"].append(1.0);
+  root[1]["list"].append(2.5);
+  root[1]["map"]["n"] = 3u;
+  JSONTEST_ASSERT_STRING_EQUAL("[2,3]\n",
+                               select("$[?@.list == $[1].list].map.n"));
+  JSONTEST_ASSERT_STRING_EQUAL("[]\n", select("$[?@.map == $[1].list].map.n"));
+  JSONTEST_ASSERT_STRING_EQUAL("[3]\n", select("$[?@.map.n == 3.0].map.n"));
+}
+
+JSONTEST_FIXTURE_LOCAL(QueryTest, skipsUnassignedElements) {
+  root = Json::Value();
+  root[3] = "d";
+  root[1] = "b";
+  JSONTEST_ASSERT_STRING_EQUAL("[]\n", select("$[0]"));
+  JSONTEST_ASSERT_STRING_EQUAL("[]\n", select("$[-2]"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"d\"]\n", select("$[-1]"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"b\",\"d\"]\n", select("$[0:4]"));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"d\",\"b\"]\n", select("$[::-1]"));
+}
+
+JSONTEST_FIXTURE_LOCAL(QueryTest, escapedQuotesMatchTheDelimiter) {
+  root = Json::Value();
+  root["a'b"] = 1;
+  root["a\"b"] = 2;
+  JSONTEST_ASSERT_STRING_EQUAL("[1,2]\n", select(R"($['a\'b',"a\"b"])"));
+}
+
+JSONTEST_FIXTURE_LOCAL(QueryTest, reportsSyntaxErrors) {
+  char const* const invalid[] = {"",
+                                 "store",
+                                 "$.",
+                                 "$..",
+                                 "$[",
+                                 "$[01]",
+                                 "$[-0]",
+                                 "$[9007199254740992]",
+                                 "$['a'",
+                                 "$['\\x']",
+                                 "$['\\\"']",
+                                 "$[\"\\'\"]",
+                                 "$[?@.a == @..b]",
+                                 "$[?@.a == 1 ==]",
+                                 "$[?match(@.a, 'x')]",
+                                 "$[?@.a == 01]",
+                                 "$[?@.a == -01.5]",
+                                 "$.a "};
+  for (char const* expression : invalid) {
+    Json::Query query;
+    Json::String error;
+    JSONTEST_ASSERT(!Json::Query::compile(expression, &query, &error))
+        << expression;
+    JSONTEST_ASSERT(error.find(" at offset ") != Json::String::npos);
+  }
+  Json::Query empty;
+  JSONTEST_ASSERT(empty.select(root).empty());
+}
+
+JSONTEST_FIXTURE_LOCAL(QueryTest, streamsLikeTheTree) {
+  Json::String const text = Json::FastWriter().write(root);
+  char const* const expressions[] = {
+      "$",
+      "$.store.book[*].author",
+      "$..author",
+      "$.store.*",
+      "$..price",
+      "$..book[1:4:2]",
+      "$..[0]",
+      "$.store[\"b\\u0069cycle\"]",
+      "$.missing..x"};
+  for (char const* expression : expressions) {
+    Json::Query query;
+    JSONTEST_ASSERT(Json::Query::compile(expression, &query, nullptr));
+    JSONTEST_ASSERT(query.isStreamable()) << expression;
+    std::vector<Json::StringView> texts;
+    JSONTEST_ASSERT(
+        query.selectText(text.data(), text.data() + text.size(), texts));
+    Json::Value streamed(Json::arrayValue);
+    CharReaderPtr reader(Json::CharReaderBuilder().newCharReader());
+    for (Json::StringView view : texts) {
+      Json::Value value;
+      JSONTEST_ASSERT(
+          reader->parse(view.begin(), view.end(), &value, nullptr));
+      streamed.append(value);
+    }
+    // The tree visits object members in key order and so does FastWriter,
+    // so both orders agree on this document.
+    JSONTEST_ASSERT_STRING_EQUAL(select(expression),
+                                 Json::FastWriter().write(streamed))
+        << expression;
+  }
+
+  Json::Query query;
+  Json::Query::compile("$..book[?@.price < 10]", &query, nullptr);
+  JSONTEST_ASSERT(!query.isStreamable());
+  Json::Query::compile("$..book[-1]", &query, nullptr);
+  JSONTEST_ASSERT(!query.isStreamable());
+  Json::Query::compile("$.a[*]", &query, nullptr);
+  std::vector<Json::StringView> texts;
+  JSONTEST_ASSERT(!query.selectText(text.data(), text.data() + 10, texts));
+
+  // Containers that cannot match are skipped, but their syntax is checked.
+  Json::Query::compile("$.b", &query, nullptr);
+  char const* const malformed[] = {
+      R"({"a": [1}, "b": 2})", R"({"a": [1 2], "b": 2})",
+      R"({"a": {"x" 1}, "b": 2})", R"({"a": [01], "b": 2})",
+      R"({"a": [1.], "b": 2})", R"({"a": ["\q"], "b": 2})",
+      R"({"a": [nul], "b": 2})", R"({"a": [1,], "b": 2})",
+      R"({"b": 2} x)"};
+  for (Json::String const bad : malformed) {
+    texts.clear();
+    JSONTEST_ASSERT(
+        !query.selectText(bad.data(), bad.data() + bad.size(), texts))
+        << bad;
+  }
+  Json::String const good =
+      R"({"a": [{"x": [-0.5e+3, "\u00e9\n"]}, [], {}, true], "b": 2})";
+  texts.clear();
+  JSONTEST_ASSERT(
+      query.selectText(good.data(), good.data() + good.size(), texts));
+  JSONTEST_ASSERT_EQUAL(1u, texts.size());
+  JSONTEST_ASSERT_STRING_EQUAL("2", texts[0].toString());
+}
+
+struct DeepValueTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(DeepValueTest, copyAndDestroyDoNotRecurse) {
+  // Deep enough to overflow the stack if copying, destroying, comparing or
+  // measuring recursed once per level.
+  int const depth = 200000;
+  Json::Value root;
+  Json::Value* node = &root;
+  for (int i = 0; i < depth; ++i) {
+    Json::Value& child =
+        (i % 2) ? node->append(Json::Value()) : (*node)["member"];
+    node->setComment(Json::String("// level"), Json::commentBefore);
+    node = &child;
+  }
+  *node = "leaf";
+
+  Json::Value copy(root);
+  Json::Value const* original = &root;
+  Json::Value const* copied = &copy;
+  int levels = 0;
+  while (copied->isArray() || copied->isObject()) {
+    JSONTEST_ASSERT_EQUAL(original->type(), copied->type());
+    JSONTEST_ASSERT_EQUAL(1u, copied->size());
+    JSONTEST_ASSERT(copied != original);
+    JSONTEST_ASSERT(copied->hasComment(Json::commentBefore));
+    original = copied->isArray() ? &(*original)[0] : &(*original)["member"];
+    copied = copied->isArray() ? &(*copied)[0] : &(*copied)["member"];
+    ++levels;
+  }
+  JSONTEST_ASSERT_EQUAL(depth, levels);
+  JSONTEST_ASSERT_STRING_EQUAL("leaf", copied->asString());
+  JSONTEST_ASSERT_EQUAL(root.hash(), copy.hash());
+  JSONTEST_ASSERT(root == copy);
+  JSONTEST_ASSERT_EQUAL(0, root.compare(copy));
+  *const_cast<Json::Value*>(copied) = "leaves";
+  JSONTEST_ASSERT(root != copy);
+  JSONTEST_ASSERT(root < copy);
+  Json::MemoryUsage const usage = root.memoryUsage();
+  JSONTEST_ASSERT_EQUAL(static_cast<size_t>(depth) + 1, usage.nodes);
+  JSONTEST_ASSERT_EQUAL(static_cast<size_t>(depth) + 1, usage.maxDepth);
+
+  root = Json::Value();
+  copy = Json::Value();
+  JSONTEST_ASSERT(copy.isNull());
+}
+
+JSONTEST_FIXTURE_LOCAL(DeepValueTest, comparisonMatchesNestedOrdering) {
+  Json::Value shorter;
+  shorter["a"]["b"] = "xyz";
+  Json::Value longer;
+  longer["a"]["b"] = "xy";
+  longer["a"]["c"] = 0;
+  // Sizes are compared before contents, at every level.
+  JSONTEST_ASSERT(shorter < longer);
+  JSONTEST_ASSERT_EQUAL(-1, shorter.compare(longer));
+  JSONTEST_ASSERT_EQUAL(1, longer.compare(shorter));
+
+  longer["a"].removeMember("c");
+  // Then by key, and within the same key by value.
+  JSONTEST_ASSERT(longer < shorter);
+  JSONTEST_ASSERT(longer != shorter);
+  longer["a"]["b"] = "xyz";
+  JSONTEST_ASSERT(longer == shorter);
+  JSONTEST_ASSERT_EQUAL(0, longer.compare(shorter));
+
+  Json::Value nan;
+  nan["list"].append(std::numeric_limits<double>::quiet_NaN());
+  JSONTEST_ASSERT(nan != nan);
+  JSONTEST_ASSERT_EQUAL(0, nan.compare(nan));
+}
+
+struct ValueHashTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(ValueHashTest, followsEquality) {
+  Json::Value first;
+  first["b"] = 2;
+  first["a"]["list"].append("text");
+  first["a"]["list"].append(1.5);
+  Json::Value second;
+  second["a"]["list"].append("text");
+  second["a"]["list"].append(1.5);
+  second["b"] = 2;
+  second.setComment(Json::String("// ignored"), Json::commentBefore);
+  JSONTEST_ASSERT(first == second);
+  JSONTEST_ASSERT_EQUAL(first.hash(), second.hash());
+
+  JSONTEST_ASSERT_EQUAL(Json::Value(0.0).hash(), Json::Value(-0.0).hash());
+  JSONTEST_ASSERT(Json::Value("ab").hash() != Json::Value("ba").hash());
+  JSONTEST_ASSERT(Json::Value(1).hash() != Json::Value(true).hash());
+
+  second["b"] = 3;
+  JSONTEST_ASSERT(first.hash() != second.hash());
+  Json::Value array(Json::arrayValue);
+  array.append(1);
+  array.append(2);
+  Json::Value reversed(Json::arrayValue);
+  reversed.append(2);
+  reversed.append(1);
+  JSONTEST_ASSERT(array.hash() != reversed.hash());
+
+  std::unordered_set<Json::Value> set;
+  set.insert(first);
+  set.insert(second);
+  set.insert(first);
+  JSONTEST_ASSERT_EQUAL(2u, set.size());
+  JSONTEST_ASSERT_EQUAL(1u, set.count(second));
+}
+
+JSONTEST_FIXTURE_LOCAL(ValueHashTest, cacheMatchesDirectHash) {
+  Json::Value root;
+  root["users"][0]["name"] = "first";
+  root["users"][1]["name"] = "second";
+  root["count"] = 2;
+  Json::ValueHashCache cache;
+  JSONTEST_ASSERT_EQUAL(root["users"].hash(), cache.hash(root["users"]));
+  JSONTEST_ASSERT_EQUAL(3u, cache.size());
+  JSONTEST_ASSERT_EQUAL(root.hash(), cache.hash(root));
+  JSONTEST_ASSERT_EQUAL(4u, cache.size());
+  JSONTEST_ASSERT_EQUAL(root.hash(), cache.hash(root));
+  cache.clear();
+  JSONTEST_ASSERT_EQUAL(0u, cache.size());
+}
+
+struct ValueReclaimerTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(ValueReclaimerTest, freesEveryReleasedTree) {
+  Json::ValueReclaimer reclaimer(4);
+  int const trees = 20;
+  for (int i = 0; i < trees; ++i) {
+    Json::Value tree;
+    for (int j = 0; j < 100; ++j)
+      tree["items"].append("a string too long for inline storage");
+    reclaimer.release(std::move(tree));
+    JSONTEST_ASSERT(tree.isNull());
+  }
+  Json::Value scalar("not worth queuing");
+  reclaimer.release(std::move(scalar));
+  JSONTEST_ASSERT(scalar.isNull());
+
+  reclaimer.drain();
+  Json::ReclaimerStats const stats = reclaimer.stats();
+  JSONTEST_ASSERT_EQUAL(4u, stats.capacity);
+  JSONTEST_ASSERT_EQUAL(0u, stats.pending);
+  JSONTEST_ASSERT(stats.deferred >= 1u);
+  JSONTEST_ASSERT(stats.highWater >= 1u && stats.highWater <= 4u);
+  JSONTEST_ASSERT_EQUAL(stats.deferred, stats.reclaimed);
+  JSONTEST_ASSERT_EQUAL(size_t(trees + 1),
+                        stats.deferred + stats.releasedInline);
+}
+
+JSONTEST_FIXTURE_LOCAL(ValueReclaimerTest, deferredReleaseUsesSharedQueue) {
+  Json::ValueReclaimer& shared = Json::ValueReclaimer::shared();
+  size_t const before = shared.stats().deferred;
+  Json::Value tree(Json::arrayValue);
+  tree.append(Json::Value(Json::objectValue))["key"] = "value";
+  Json::deferredRelease(std::move(tree));
+  JSONTEST_ASSERT(tree.isNull());
+  shared.drain();
+  JSONTEST_ASSERT_EQUAL(before + 1, shared.stats().deferred);
+  JSONTEST_ASSERT_EQUAL(0u, shared.stats().pending);
+}
+
+struct LineIndexTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(LineIndexTest, mixedLineEndings) {
+  Json::String const doc = "ab\ncd\r\nef\rgh";
+  Json::LineIndex const index(doc.data(), doc.data() + doc.size());
+  JSONTEST_ASSERT_EQUAL(4u, index.lineCount());
+  int line = 0;
+  int column = 0;
+  index.lineAndColumn(0, line, column);
+  JSONTEST_ASSERT_EQUAL(1, line);
+  JSONTEST_ASSERT_EQUAL(1, column);
+  index.lineAndColumn(4, line, column);
+  JSONTEST_ASSERT_EQUAL(2, line);
+  JSONTEST_ASSERT_EQUAL(2, column);
+  index.lineAndColumn(7, line, column);
+  JSONTEST_ASSERT_EQUAL(3, line);
+  JSONTEST_ASSERT_EQUAL(1, column);
+  index.lineAndColumn(11, line, column);
+  JSONTEST_ASSERT_EQUAL(4, line);
+  JSONTEST_ASSERT_EQUAL(2, column);
+  index.lineAndColumn(100, line, column);
+  JSONTEST_ASSERT_EQUAL(4, line);
+  JSONTEST_ASSERT_EQUAL(3, column);
+
+  Json::LineIndex const empty;
+  JSONTEST_ASSERT_EQUAL(1u, empty.lineCount());
+}
+
+JSONTEST_FIXTURE_LOCAL(LineIndexTest, mapsValueOffsets) {
+  Json::String const doc = "{\n  \"a\": 1,\n  \"b\": [true,\n    \"x\"]\n}";
+  Json::CharReaderBuilder builder;
+  CharReaderPtr reader(builder.newCharReader());
+  Json::Value root;
+  Json::String errs;
+  JSONTEST_ASSERT(
+      reader->parse(doc.data(), doc.data() + doc.size(), &root, &errs));
+  Json::LineIndex const index(doc.data(), doc.data() + doc.size());
+  int line = 0;
+  int column = 0;
+  index.lineAndColumn(root["a"].getOffsetStart(), line, column);
+  JSONTEST_ASSERT_EQUAL(2, line);
+  JSONTEST_ASSERT_EQUAL(8, column);
+  index.lineAndColumn(root["b"][1].getOffsetStart(), line, column);
+  JSONTEST_ASSERT_EQUAL(4, line);
+  JSONTEST_ASSERT_EQUAL(5, column);
+}
+
+JSONTEST_FIXTURE_LOCAL(LineIndexTest, formatsErrorPositions) {
+  Json::String const doc = "[1,\r\n 2,\r\n ?,\n ?]";
+  Json::Reader reader;
+  Json::Value root;
+  JSONTEST_ASSERT(!reader.parse(doc, root));
+  JSONTEST_ASSERT_STRING_EQUAL("* Line 3, Column 2\n"
+                               "  Syntax error: value, object or array "
+                               "expected.\n",
+                               reader.getFormattedErrorMessages());
+}
+
+struct CharReaderReuseTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(CharReaderReuseTest, parsesManyDocuments) {
+  Json::CharReaderBuilder builder;
+  CharReaderPtr reader(builder.newCharReader());
+  Json::String errs;
+  Json::Value root;
+  for (int i = 0; i < 3; ++i) {
+    Json::String const doc = "{\"outer\": {\"inner\": \"a value longer than "
+                             "the small string buffer\"}, \"next\": [\"x\", " +
+                             std::to_string(i) + "]}";
+    JSONTEST_ASSERT(
+        reader->parse(doc.data(), doc.data() + doc.size(), &root, &errs));
+    JSONTEST_ASSERT_STRING_EQUAL(
+        "a value longer than the small string buffer",
+        root["outer"]["inner"].asString());
+    JSONTEST_ASSERT_STRING_EQUAL("x", root["next"][0].asString());
+    JSONTEST_ASSERT_EQUAL(i, root["next"][1].asInt());
+    JSONTEST_ASSERT_EQUAL(2u, root.size());
+  }
+}
+
+JSONTEST_FIXTURE_LOCAL(CharReaderReuseTest, resetForgetsErrors) {
+  Json::CharReaderBuilder builder;
+  CharReaderPtr reader(builder.newCharReader());
+  Json::String const bad = "[1, ?]";
+  Json::String errs;
+  Json::Value root;
+  JSONTEST_ASSERT(
+      !reader->parse(bad.data(), bad.data() + bad.size(), &root, &errs));
+  JSONTEST_ASSERT_EQUAL(1u, reader->getStructuredErrors().size());
+  reader->reset();
+  JSONTEST_ASSERT(reader->getStructuredErrors().empty());
+
+  Json::String const good = "{\"a\": 1}";
+  JSONTEST_ASSERT(
+      reader->parse(good.data(), good.data() + good.size(), &root, &errs));
+  JSONTEST_ASSERT(errs.empty());
+  JSONTEST_ASSERT_EQUAL(1, root["a"].asInt());
+}
+
+struct RecycleValuesTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE_LOCAL(RecycleValuesTest, matchesFreshParse) {
+  Json::CharReaderBuilder builder;
+  builder["recycleValues"] = true;
+  builder["rejectDupKeys"] = true;
+  CharReaderPtr reader(builder.newCharReader());
+  Json::CharReaderBuilder freshBuilder;
+  CharReaderPtr fresh(freshBuilder.newCharReader());
+  Json::String const docs[] = {
+      "{\"id\": \"a fairly long identifier string\", \"tags\": [1, 2, 3], "
+      "\"gone\": {\"x\": 1}, \"kind\": [true]}",
+      "// note\n{\"id\": \"short\", \"tags\": [4], \"kind\": {\"y\": null}}",
+      "{\"id\": \"a string longer than any before it\", \"tags\": [], "
+      "\"new\": 2.5}",
+      "[\"not\", \"an\", \"object\"]",
+  };
+  Json::Value root;
+  for (Json::String const& doc : docs) {
+    Json::String errs;
+    JSONTEST_ASSERT(
+        reader->parse(doc.data(), doc.data() + doc.size(), &root, &errs));
+    Json::Value expected;
+    JSONTEST_ASSERT(
+        fresh->parse(doc.data(), doc.data() + doc.size(), &expected, &errs));
+    JSONTEST_ASSERT_EQUAL(expected, root);
+    JSONTEST_ASSERT_STRING_EQUAL(expected.toStyledString(),
+                                 root.toStyledString());
+    JSONTEST_ASSERT_EQUAL(expected.getOffsetStart(), root.getOffsetStart());
+    JSONTEST_ASSERT_EQUAL(expected.getOffsetLimit(), root.getOffsetLimit());
+  }
+
+  Json::String const dup = "{\"a\": 1, \"a\": 2}";
+  Json::Value object(Json::objectValue);
+  object["a"] = 0;
+  Json::String errs;
+  JSONTEST_ASSERT(
+      !reader->parse(dup.data(), dup.data() + dup.size(), &object, &errs));
+  JSONTEST_ASSERT(errs.find("Duplicate key: 'a'") != Json::String::npos);
+}
+
+JSONTEST_FIXTURE_LOCAL(RecycleValuesTest, failedParseMatchesFreshParse) {
+  Json::CharReaderBuilder builder;
+  builder["recycleValues"] = true;
+  CharReaderPtr reader(builder.newCharReader());
+  Json::CharReaderBuilder freshBuilder;
+  CharReaderPtr fresh(freshBuilder.newCharReader());
+  Json::String const good =
+      "{\"id\": \"a fairly long identifier string\", \"tags\": [1, 2, 3], "
+      "\"gone\": {\"x\": 1, \"y\": [2]}, \"kind\": [true]}";
+  // Each fails part way, leaving members and elements of the previous
+  // document unparsed.
+  Json::String const bad[] = {
+      "{\"id\": \"short\", \"tags\": [4, tru",
+      "{\"tags\": [4, 5] \"kind\": 1}",
+      "{\"gone\": {\"x\": 2, \"y\" 3}}",
+      "{\"id\": \"\\uZZZZ\", \"kind\": []}",
+      "{\"kind\": [false, }",
+  };
+  for (Json::String const& doc : bad) {
+    Json::Value root;
+    Json::String errs;
+    JSONTEST_ASSERT(
+        reader->parse(good.data(), good.data() + good.size(), &root, &errs));
+    JSONTEST_ASSERT(
+        !reader->parse(doc.data(), doc.data() + doc.size(), &root, &errs));
+    Json::Value expected;
+    JSONTEST_ASSERT(
+        !fresh->parse(doc.data(), doc.data() + doc.size(), &expected, &errs));
+    JSONTEST_ASSERT_EQUAL(expected, root);
+    JSONTEST_ASSERT_STRING_EQUAL(expected.toStyledString(),
+                                 root.toStyledString());
+  }
+}
+
+JSONTEST_FIXTURE_LOCAL(RecycleValuesTest, steadyStateDoesNotAllocate) {
+  Json::CharReaderBuilder builder;
+  builder["recycleValues"] = true;
+  CharReaderPtr reader(builder.newCharReader());
+  Json::String const first =
+      "{\"user\": \"someone with a long name\", \"scores\": [1, 2, 3]}";
+  Json::String const second =
+      "{\"user\": \"another long user name\", \"scores\": [4, 5]}";
+  Json::Value root;
+  JSONTEST_ASSERT(
+      reader->parse(first.data(), first.data() + first.size(), &root, nullptr));
+
+  Json::AllocationCounter counter;
+  if (!Json::setAllocationObserver(&counter))
+    return;
+  bool const ok = reader->parse(second.data(), second.data() + second.size(),
+                                &root, nullptr);
+  Json::setAllocationObserver(nullptr);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT_EQUAL(0u, counter.totalCount());
+  JSONTEST_ASSERT_STRING_EQUAL("another long user name",
+                               root["user"].asString());
+  JSONTEST_ASSERT_EQUAL(2u, root["scores"].size());
+}
+
 struct ReaderTest : JsonTest::TestCase {
   void setStrictMode() {
     reader = std::unique_ptr<Json::Reader>(